@@ -193,10 +193,16 @@ classdef (Abstract)ServoMotorBase < matlabshared.addon.LibraryBase
             max = typecast(uint16(max), 'uint8');
             try
                 peripheralPayload = [getPinNumber(obj.Parent, obj.Pin), min, max];
-                writeStatus = rawWrite(obj.Parent.Protocol, obj.ATTACH_SERVO, peripheralPayload);
+                responsePeripheralPayloadSize = 1;
+                % 0 when the board has no timer or channel left for the servo
+                writeStatus = rawRead(obj.Parent.Protocol, obj.ATTACH_SERVO, peripheralPayload, responsePeripheralPayloadSize);
             catch e
                 throwAsCaller(e);
             end
+            if writeStatus(1) == 0
+                obj.localizedError('MATLAB:hwsdk:general:maxServos', ...
+                    obj.Parent.Board, num2str(getResourceCount(obj.Parent, obj.ResourceOwner) - 1));
+            end
             obj.IsServoAttached = true;
         end
         
@@ -68,7 +68,8 @@ classdef ArduinoConstants
         ServoReservedPins = {'D9', 'D10'};
         ServoReservedPinsMega = {'D11', 'D12'};
         MaxServos = 12;
-        MaxServosMega = 48;
+        % Servo's fourth timer on the Mega, Timer4, runs the scheduler
+        MaxServosMega = 36;
         MaxServosDue = 52;
         MaxServosNano33BLE = 22;
         MaxServosESP32 = 16;
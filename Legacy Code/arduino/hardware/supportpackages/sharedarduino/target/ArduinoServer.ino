@@ -9,20 +9,26 @@ extern "C"{
 #include "IO_server.h"
 #include "IO_packet.h"
 #include "scheduler_configuration.h"
+#include "schedulerArduino.h"
 #include "rt_OneStep.h"
+#include "pulseTrainArduino.h"
+#include "eventJournalArduino.h"
+#include "edgeWatchArduino.h"
+#include "debounceArduino.h"
+#include "analogScanArduino.h"
+#include "analogTriggerArduino.h"
+#include "pwmWaveformArduino.h"
+#include "i2cQueueArduino.h"
+#include "i2cPollArduino.h"
 /*To get the ADD_ON marco definition*/
 #include "peripheralIncludes.h"
 #if ADD_ON
 #include "hardware.h"
 #include "MWArduinoClass.h"
+#include "addOnLoopArduino.h"
 extern MWArduinoClass hwObject;
 #endif
 
-
-// Used for soft Real Time implementation
-unsigned long oldtime = 0L;
-unsigned long actualtime;
-
 /*IO Server End*/
 
 
@@ -49,24 +55,38 @@ void setup()
 
 void loop()
 {
-/* Execute loop function for all the add-on libraries*/
+    /* Pulse train edges that are due, ahead of anything that may take a while */
+    runPulseTrains();
+    runPwmWaveforms();
+    /* Work the host has moved to a rate group runs from rt_OneStep() while streaming */
+    runLoopTask(runAnalogScan);
+    runLoopTask(runAnalogTriggers);
+    runLoopTask(runDebounceFilters);
+    runLoopTask(watchJournalInputs);
+#if IO_STANDARD_I2C
+    /* Polls that are due join the queue ahead of its step, long reads go on over several passes */
+    runLoopTask(runI2CPolls);
+    runI2CTransfers();
+#endif
+/* Execute loop function for the add-on libraries within their time budget*/
 #if ADD_ON
-    LibraryBase* tempLib = NULL;
-    for(int count = 0; count < hwObject.noOfLibraries; count++)    
-    {
-        tempLib = hwObject.arrayOfLibraries[count];
-        tempLib->loop();
-    }
+#if IO_STANDARD_I2C
+    /* The add-on libraries use Wire directly, in their loop() and their commands, so no transfer may hold the bus past here.
+     * With add-ons a queued transfer therefore completes in the pass it starts, it does not overlap the add-on loops */
+    finishI2CTransfer();
+#endif
+    runAddOnLoops();
 #endif
-      if(StreamingModeFlag)
+      /* The base rate is kept by the scheduler timer where the board has one,
+       * otherwise schedulerStepDue() falls back to comparing micros() against deltaT */
+      if(StreamingModeFlag && schedulerStepDue())
       {
-          actualtime = micros();
-          if((actualtime - oldtime) >= deltaT)
-          {	             
-              oldtime = actualtime;
-              rt_OneStep();
-          }
+          rt_OneStep();
       }
+    runPulseTrains();
+    /* Edges and crossings go out between responses, never inside one */
+    sendEdgeEvents();
+    sendAnalogTriggerEvents();
 // Run background server also to respond to on-demand requests
     server((uint8_T*)&PayloadBufferRxBackground,(uint8_T*)&PayloadBufferTxBackground,(uint8_T)1);
 }
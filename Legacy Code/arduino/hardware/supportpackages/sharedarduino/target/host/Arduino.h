@@ -0,0 +1,167 @@
+/**
+ * @file Arduino.h
+ *
+ * Arduino core API for the Linux host build of the IO server. Pins, the clock
+ * and Serial are virtual, they are implemented in hostArduino.cpp. The host*()
+ * functions at the end let a harness drive the virtual hardware.
+ *
+ */
+#ifndef _ARDUINO_HOST_H_
+#define _ARDUINO_HOST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ARDUINO_ARCH_HOST 1
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define DEFAULT  1
+#define EXTERNAL 0
+
+/* Virtual board: 64 digital pins grouped in 8-bit ports, the first 16 of which
+ * also have an analog input. */
+#define NUM_DIGITAL_PINS  64
+#define NUM_ANALOG_INPUTS 16
+#define HOST_NUM_PORTS    (NUM_DIGITAL_PINS/8)
+
+#define NOT_A_PORT         0
+#define NOT_AN_INTERRUPT   -1
+
+#define digitalPinToPort(P)          ((uint8_t)((P) < NUM_DIGITAL_PINS ? ((P)/8 + 1) : NOT_A_PORT))
+#define digitalPinToBitMask(P)       ((uint8_t)(1 << ((P) % 8)))
+#define digitalPinToInterrupt(P)     ((P) < NUM_DIGITAL_PINS ? (P) : NOT_AN_INTERRUPT)
+#define portInputRegister(P)         (&hostPortLevel[(P)])
+#define portOutputRegister(P)        (&hostPortLevel[(P)])
+
+#define bitRead(value, bit)  (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)   ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pin levels, one byte per port, index 0 is NOT_A_PORT. Input and output
+ * registers alias the same level, like PINx follows PORTx on an output pin. */
+extern volatile uint8_t hostPortLevel[HOST_NUM_PORTS + 1];
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReference(uint8_t mode);
+void analogReadResolution(int bits);
+void analogWrite(uint8_t pin, int val);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+void interrupts(void);
+void noInterrupts(void);
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration);
+void noTone(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder);
+
+/* Virtual hardware controls */
+typedef enum
+{
+    HOST_CLOCK_REAL = 0,    /* micros() follows CLOCK_MONOTONIC */
+    HOST_CLOCK_VIRTUAL      /* micros() only moves on delay, hostAdvanceClock and one tick per read */
+} hostClockMode_T;
+
+void hostSetClockMode(hostClockMode_T mode);
+void hostAdvanceClock(unsigned long us);
+void hostSetPin(uint8_t pin, uint8_t level);    /* Drives an input pin, runs attached interrupts */
+void hostSetAnalog(uint8_t pin, uint16_t value);
+int hostGetPwm(uint8_t pin);
+uint8_t hostGetPinMode(uint8_t pin);
+
+#ifdef __cplusplus
+}
+
+static inline void tone(uint8_t pin, unsigned int frequency) { tone(pin, frequency, 0); }
+static inline unsigned long pulseIn(uint8_t pin, uint8_t state) { return pulseIn(pin, state, 1000000UL); }
+
+template<class T, class L> static inline auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template<class T, class L> static inline auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+/* Serial port backed by a file descriptor, hostMain.cpp connects it to a pty
+ * or an accepted TCP socket. read() returns -1 when nothing is pending. With
+ * capture() set, every request is written out with the bytes sent back for it
+ * as one line of a benchmark request mix (see hostBench.cpp). */
+class HardwareSerial
+{
+public:
+    HardwareSerial();
+    void begin(unsigned long baud) { (void)baud; }
+    void begin(unsigned long baud, uint8_t config) { (void)baud; (void)config; }
+    void end(void) {}
+    int available(void);
+    int peek(void);
+    int read(void);
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    void flush(void) {}
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size);
+    size_t print(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+    size_t println(const char *str) { return print(str) + print("\r\n"); }
+    operator bool() { return _fd >= 0; }
+
+    void attach(int fd);
+    int fd(void) const { return _fd; }
+    bool hungUp(void) const { return _hungUp; }
+    void capture(void *file) { _capture = file; _requestLength = 0; _responseLength = 0; }
+    void flushCapture(void);
+    unsigned long bytesIn;
+    unsigned long bytesOut;
+    unsigned long writes;
+
+private:
+    int fill(int wait);
+
+    int _fd;
+    int _peek;
+    bool _hungUp;
+    unsigned long _timeout;
+    void *_capture;
+    uint8_t _request[1024];
+    size_t _requestLength;
+    uint8_t _response[1024];
+    size_t _responseLength;
+};
+
+extern HardwareSerial Serial;
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * @file MacroIncludeIO.h
+ *
+ * Serial transport settings for the Linux host build. The baud rate is only
+ * passed to Serial.begin(), the pty or socket runs as fast as the host can.
+ *
+ */
+#ifndef Macro_Include_h
+#define Macro_Include_h
+
+#define CUSTOM_SERIAL_COMPORTBAUD 115200
+#define CUSTOM_EXPECTED_FIRSTBYTE_SERIAL 0xAA
+#define serialPort Serial
+
+#endif
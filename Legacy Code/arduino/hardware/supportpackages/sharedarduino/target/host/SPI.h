@@ -0,0 +1,41 @@
+/**
+ * @file SPI.h
+ *
+ * SPI for the Linux host build. MISO is looped back to MOSI, so every
+ * transfer returns the byte it sent.
+ *
+ */
+#ifndef _SPI_HOST_H_
+#define _SPI_HOST_H_
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+public:
+    SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clockFreq, uint8_t order, uint8_t mode) : clock(clockFreq), bitOrder(order), dataMode(mode) {}
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass
+{
+public:
+    void begin(void) {}
+    void end(void) {}
+    void beginTransaction(SPISettings settings) { (void)settings; }
+    void endTransaction(void) {}
+    uint8_t transfer(uint8_t data) { return data; }
+    void transfer(void *buf, size_t count) { (void)buf; (void)count; }
+};
+
+extern SPIClass SPI;
+
+#endif
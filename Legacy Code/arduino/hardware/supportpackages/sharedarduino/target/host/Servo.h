@@ -0,0 +1,28 @@
+/**
+ * @file Servo.h
+ *
+ * Servo for the Linux host build, it only remembers the last angle written.
+ *
+ */
+#ifndef _SERVO_HOST_H_
+#define _SERVO_HOST_H_
+
+#include "Arduino.h"
+
+class Servo
+{
+public:
+    Servo() : pin(-1), angle(90) {}
+    uint8_t attach(int signalPin) { return attach(signalPin, 544, 2400); }
+    uint8_t attach(int signalPin, int minPulse, int maxPulse) { (void)minPulse; (void)maxPulse; pin = signalPin; return 0; }
+    void detach(void) { pin = -1; }
+    void write(int value) { angle = constrain(value, 0, 180); }
+    int read(void) { return angle; }
+    bool attached(void) { return pin >= 0; }
+
+private:
+    int pin;
+    int angle;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file Wire.h
+ *
+ * TwoWire for the Linux host build. The bus carries virtual register devices
+ * added with hostI2CAddDevice(): the first byte of a write selects the
+ * register, further bytes are stored from there on and reads continue from
+ * the selected register, like most I2C sensors.
+ *
+ */
+#ifndef _WIRE_HOST_H_
+#define _WIRE_HOST_H_
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+#define HOST_I2C_MAX_DEVICES 8
+
+class TwoWire
+{
+public:
+    TwoWire();
+    void begin(void) {}
+    void end(void) {}
+    void setClock(uint32_t clock) { (void)clock; }
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop);
+    uint8_t endTransmission(void) { return endTransmission((uint8_t)1); }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity) { return requestFrom(address, quantity, (uint8_t)1); }
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)1); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t quantity);
+    int available(void) { return rxLength - rxIndex; }
+    int read(void) { return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1; }
+    int peek(void) { return (rxIndex < rxLength) ? rxBuffer[rxIndex] : -1; }
+
+private:
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxIndex;
+    uint8_t rxLength;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+    uint8_t txAddress;
+    bool transmitting;
+};
+
+extern TwoWire Wire;
+
+/* Adds a 256 byte register file at address, returns it so that a harness can
+ * seed or inspect it, or NULL when the bus is full. */
+uint8_t* hostI2CAddDevice(uint8_t address);
+
+#endif
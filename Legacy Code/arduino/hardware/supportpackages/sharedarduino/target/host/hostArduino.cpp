@@ -0,0 +1,468 @@
+/**
+ * @file hostArduino.cpp
+ *
+ * Virtual pins, clock and Serial behind the host Arduino.h.
+ *
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "Arduino.h"
+#include "SPI.h"
+
+volatile uint8_t hostPortLevel[HOST_NUM_PORTS + 1];
+
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static uint16_t analogValues[NUM_DIGITAL_PINS];
+static int pwmDuty[NUM_DIGITAL_PINS];
+static uint8_t analogResolution = 10;
+
+static void (*pinIsr[NUM_DIGITAL_PINS])(void);
+static int pinIsrMode[NUM_DIGITAL_PINS];
+static uint64_t pendingIsr;
+static bool interruptsEnabled = true;
+
+static hostClockMode_T clockMode = HOST_CLOCK_REAL;
+static uint64_t virtualMicros;
+static struct timespec clockStart;
+
+static inline bool validPin(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS;
+}
+
+static inline uint8_t pinLevel(uint8_t pin)
+{
+    return (hostPortLevel[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+static void runPendingIsr(void)
+{
+    while (interruptsEnabled && pendingIsr)
+    {
+        uint8_t pin = (uint8_t)__builtin_ctzll(pendingIsr);
+        pendingIsr &= ~(1ULL << pin);
+        if (pinIsr[pin] != NULL)
+        {
+            pinIsr[pin]();
+        }
+    }
+}
+
+/* Changes the level of a pin and raises its interrupt if the edge matches */
+static void setPinLevel(uint8_t pin, uint8_t level)
+{
+    uint8_t old = pinLevel(pin);
+    if (level)
+    {
+        hostPortLevel[digitalPinToPort(pin)] |= digitalPinToBitMask(pin);
+    }
+    else
+    {
+        hostPortLevel[digitalPinToPort(pin)] &= (uint8_t)~digitalPinToBitMask(pin);
+    }
+    if ((old != level) && (pinIsr[pin] != NULL))
+    {
+        int mode = pinIsrMode[pin];
+        if ((mode == CHANGE) || ((mode == RISING) && level) || ((mode == FALLING) && !level))
+        {
+            pendingIsr |= (1ULL << pin);
+            runPendingIsr();
+        }
+    }
+}
+
+extern "C" {
+
+    void pinMode(uint8_t pin, uint8_t mode)
+    {
+        if (!validPin(pin))
+        {
+            return;
+        }
+        pinModes[pin] = mode;
+        if (mode == INPUT_PULLUP)
+        {
+            setPinLevel(pin, HIGH);
+        }
+    }
+
+    void digitalWrite(uint8_t pin, uint8_t val)
+    {
+        if (validPin(pin) && (pinModes[pin] == OUTPUT))
+        {
+            setPinLevel(pin, val ? HIGH : LOW);
+        }
+    }
+
+    int digitalRead(uint8_t pin)
+    {
+        return validPin(pin) ? pinLevel(pin) : LOW;
+    }
+
+    int analogRead(uint8_t pin)
+    {
+        if (!validPin(pin))
+        {
+            return 0;
+        }
+        /* Stored values are 16-bit, scale them down to the configured resolution */
+        return analogValues[pin] >> (16 - analogResolution);
+    }
+
+    void analogReference(uint8_t mode)
+    {
+        (void)mode;
+    }
+
+    void analogReadResolution(int bits)
+    {
+        if ((bits > 0) && (bits <= 16))
+        {
+            analogResolution = (uint8_t)bits;
+        }
+    }
+
+    void analogWrite(uint8_t pin, int val)
+    {
+        if (validPin(pin))
+        {
+            pwmDuty[pin] = val;
+        }
+    }
+
+    unsigned long micros(void)
+    {
+        if (clockMode == HOST_CLOCK_VIRTUAL)
+        {
+            /* Every read moves the clock so that busy waits on micros() terminate */
+            return (unsigned long)(uint32_t)(virtualMicros++);
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (clockStart.tv_sec == 0 && clockStart.tv_nsec == 0)
+        {
+            clockStart = now;
+        }
+        uint64_t us = (uint64_t)(now.tv_sec - clockStart.tv_sec) * 1000000ULL
+                + (uint64_t)(now.tv_nsec - clockStart.tv_nsec) / 1000;
+        /* Wrap at 32 bits like the targets do */
+        return (unsigned long)(uint32_t)us;
+    }
+
+    unsigned long millis(void)
+    {
+        return micros() / 1000UL;
+    }
+
+    void delayMicroseconds(unsigned int us)
+    {
+        if (clockMode == HOST_CLOCK_VIRTUAL)
+        {
+            virtualMicros += us;
+            return;
+        }
+        struct timespec ts;
+        ts.tv_sec = us / 1000000U;
+        ts.tv_nsec = (long)(us % 1000000U) * 1000L;
+        while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR))
+        {
+        }
+    }
+
+    void delay(unsigned long ms)
+    {
+        while (ms > 0)
+        {
+            unsigned long chunk = (ms > 1000UL) ? 1000UL : ms;
+            delayMicroseconds((unsigned int)(chunk * 1000UL));
+            ms -= chunk;
+        }
+    }
+
+    void yield(void)
+    {
+    }
+
+    void interrupts(void)
+    {
+        interruptsEnabled = true;
+        runPendingIsr();
+    }
+
+    void noInterrupts(void)
+    {
+        interruptsEnabled = false;
+    }
+
+    void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode)
+    {
+        if (validPin(interruptNum))
+        {
+            pinIsrMode[interruptNum] = mode;
+            pinIsr[interruptNum] = userFunc;
+        }
+    }
+
+    void detachInterrupt(uint8_t interruptNum)
+    {
+        if (validPin(interruptNum))
+        {
+            pinIsr[interruptNum] = NULL;
+            pendingIsr &= ~(1ULL << interruptNum);
+        }
+    }
+
+    void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+    {
+        (void)duration;
+        if (validPin(pin))
+        {
+            pwmDuty[pin] = (frequency != 0) ? 128 : 0;
+        }
+    }
+
+    void noTone(uint8_t pin)
+    {
+        if (validPin(pin))
+        {
+            pwmDuty[pin] = 0;
+        }
+    }
+
+    /* Nothing can move a pin while the server is blocked in here, so a pulse
+     * that has not started is reported as a timeout straight away. */
+    unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout)
+    {
+        (void)pin;
+        (void)state;
+        (void)timeout;
+        return 0;
+    }
+
+    void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val)
+    {
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            uint8_t bit = (bitOrder == LSBFIRST) ? (val >> i) : (val >> (7 - i));
+            digitalWrite(dataPin, bit & 0x01);
+            digitalWrite(clockPin, HIGH);
+            digitalWrite(clockPin, LOW);
+        }
+    }
+
+    uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder)
+    {
+        uint8_t value = 0;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            digitalWrite(clockPin, HIGH);
+            if (bitOrder == LSBFIRST)
+            {
+                value |= (uint8_t)(digitalRead(dataPin) << i);
+            }
+            else
+            {
+                value |= (uint8_t)(digitalRead(dataPin) << (7 - i));
+            }
+            digitalWrite(clockPin, LOW);
+        }
+        return value;
+    }
+
+    void hostSetClockMode(hostClockMode_T mode)
+    {
+        clockMode = mode;
+    }
+
+    void hostAdvanceClock(unsigned long us)
+    {
+        virtualMicros += us;
+    }
+
+    void hostSetPin(uint8_t pin, uint8_t level)
+    {
+        if (validPin(pin) && (pinModes[pin] != OUTPUT))
+        {
+            setPinLevel(pin, level ? HIGH : LOW);
+        }
+    }
+
+    void hostSetAnalog(uint8_t pin, uint16_t value)
+    {
+        if (validPin(pin))
+        {
+            analogValues[pin] = value;
+        }
+    }
+
+    int hostGetPwm(uint8_t pin)
+    {
+        return validPin(pin) ? pwmDuty[pin] : 0;
+    }
+
+    uint8_t hostGetPinMode(uint8_t pin)
+    {
+        return validPin(pin) ? pinModes[pin] : INPUT;
+    }
+}
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+HardwareSerial::HardwareSerial() : bytesIn(0), bytesOut(0), writes(0), _fd(-1), _peek(-1), _hungUp(false), _timeout(1000), _capture(NULL), _requestLength(0), _responseLength(0)
+{
+}
+
+void HardwareSerial::attach(int fd)
+{
+    _fd = fd;
+    _peek = -1;
+    _hungUp = false;
+}
+
+/* Reads one byte into the peek slot, waiting up to wait ms for it */
+int HardwareSerial::fill(int wait)
+{
+    if (_peek >= 0)
+    {
+        return 1;
+    }
+    if (_fd < 0)
+    {
+        return 0;
+    }
+    struct pollfd pfd = { _fd, POLLIN, 0 };
+    if (poll(&pfd, 1, wait) <= 0)
+    {
+        return 0;
+    }
+    uint8_t c;
+    ssize_t n = ::read(_fd, &c, 1);
+    if (n != 1)
+    {
+        /* End of file on a socket, EIO on a pty master whose slave was closed */
+        if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+        {
+            _hungUp = true;
+        }
+        return 0;
+    }
+    bytesIn++;
+    if (_capture != NULL)
+    {
+        /* The first byte after a response starts the next request */
+        if (_responseLength > 0)
+        {
+            flushCapture();
+        }
+        if (_requestLength < sizeof(_request))
+        {
+            _request[_requestLength++] = c;
+        }
+    }
+    _peek = c;
+    return 1;
+}
+
+int HardwareSerial::available(void)
+{
+    int pending = 0;
+    if (_fd >= 0)
+    {
+        ioctl(_fd, FIONREAD, &pending);
+    }
+    return pending + ((_peek >= 0) ? 1 : 0);
+}
+
+int HardwareSerial::peek(void)
+{
+    return fill(0) ? _peek : -1;
+}
+
+int HardwareSerial::read(void)
+{
+    if (!fill(0))
+    {
+        return -1;
+    }
+    int c = _peek;
+    _peek = -1;
+    return c;
+}
+
+size_t HardwareSerial::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+    while ((count < length) && fill((int)_timeout))
+    {
+        buffer[count++] = (uint8_t)_peek;
+        _peek = -1;
+    }
+    return count;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    size_t sent = 0;
+    if (_fd < 0)
+    {
+        return 0;
+    }
+    writes++;
+    /* Sends with no request before them (streaming, debug messages) are not
+     * responses and are left out of the capture */
+    if (_capture != NULL && _requestLength > 0)
+    {
+        for (size_t i = 0; i < size && _responseLength < sizeof(_response); i++)
+        {
+            _response[_responseLength++] = buffer[i];
+        }
+    }
+    while (sent < size)
+    {
+        ssize_t n = ::write(_fd, buffer + sent, size - sent);
+        if (n > 0)
+        {
+            sent += (size_t)n;
+        }
+        else if ((n < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+        {
+            struct pollfd pfd = { _fd, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+        }
+        else
+        {
+            break;
+        }
+    }
+    bytesOut += sent;
+    return sent;
+}
+
+/* Writes the pending request as "1 captured <request> <response>" in hex */
+void HardwareSerial::flushCapture(void)
+{
+    FILE *file = (FILE *)_capture;
+    if (file == NULL || _requestLength == 0)
+    {
+        return;
+    }
+    fprintf(file, "1 captured ");
+    for (size_t i = 0; i < _requestLength; i++)
+    {
+        fprintf(file, "%02X", _request[i]);
+    }
+    fputc(' ', file);
+    for (size_t i = 0; i < _responseLength; i++)
+    {
+        fprintf(file, "%02X", _response[i]);
+    }
+    fputc('\n', file);
+    fflush(file);
+    _requestLength = 0;
+    _responseLength = 0;
+}
@@ -0,0 +1,436 @@
+/**
+ * @file hostBench.cpp
+ *
+ * Request/response benchmark for the host build. It links the server in place
+ * of hostMain.cpp and a transport, and provides the rtIOStream itself: every
+ * request of a scripted mix is handed to rtIOStreamRecv, loop() runs until
+ * the response has gone out through rtIOStreamSend, and the time that took
+ * is the server cost of the request.
+ *
+ * The bench is linked with -Wl,--wrap=server, so it knows which sends come
+ * from the IO server answering the pending request. Streaming steps and the
+ * unsolicited frames (start bytes EDGE_EVENT_FRAME_START to
+ * ANALOG_TRIGGER_FRAME_START) go out from loop() around server() and are
+ * not taken for the response.
+ *
+ * Serial, WiFi and BLE are not exercised for real. Their latency is the server
+ * cost plus a first order link model (byte rate, per packet overhead, frames
+ * per connection interval for BLE) applied to the request and response sizes,
+ * so results are repeatable and can gate regressions without hardware. The
+ * loopback rows are the measured server cost alone, the rows of the other
+ * transports are marked as modeled.
+ *
+ * A request mix has one request per line, "<weight> <name> <request hex>
+ * [<expected response hex>]"; '#' starts a comment. ioserver_host -c records
+ * one from a MATLAB session, rename and reweight its lines to build a mix of
+ * digital, analog, I2C, SPI and 0xF1xx custom requests.
+ *
+ * Usage: ioserver_bench -m mix [-n requests] [-s seed] [-o results] [-g baseline [-x percent]]
+ *   -n requests  requests to time after warm-up, default 10000
+ *   -o results   write the loopback p99 of each request to this file
+ *   -g baseline  exit with 1 when a loopback p99 is more than -x percent
+ *                (default 20) above the value in this file
+ *
+ */
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+extern "C" {
+#include "rtiostream.h"
+#include "IO_server.h"
+#include "pushFrameArduino.h"
+}
+
+void setup(void);
+void loop(void);
+
+#define BENCH_WARMUP_REQUESTS 500
+#define BENCH_MAX_LOOPS       10000     /* loop() calls before a request counts as unanswered */
+
+typedef struct
+{
+    const char *name;
+    bool modeled;               /* Latency from the link model rather than measured */
+    double bytesPerUs;          /* 0 for no byte rate limit */
+    double packetOverheadUs;    /* Added once per direction */
+    unsigned frameBytes;        /* 0 when the link is a byte stream */
+    unsigned framesPerInterval;
+    double intervalUs;
+} linkModel_T;
+
+/* Serial is 115200 baud 8N1. WiFi is a TCP round trip on a quiet WLAN with the
+ * module SPI attached (WiFiNINA, ESP32). BLE sends 20 byte notifications, four
+ * per 7.5 ms connection interval. */
+static const linkModel_T linkModels[] =
+{
+    { "loopback", false, 0.0,      0.0,    0,  0, 0.0    },
+    { "serial",   true,  0.01152,  0.0,    0,  0, 0.0    },
+    { "wifi",     true,  0.125,    1500.0, 0,  0, 0.0    },
+    { "ble",      true,  0.0,      0.0,    20, 4, 7500.0 },
+};
+#define NUM_LINK_MODELS (sizeof(linkModels)/sizeof(linkModels[0]))
+
+typedef struct
+{
+    std::string name;
+    unsigned weight;
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> expected;
+    std::vector<double> serverUs;
+    size_t responseBytes;
+    unsigned long mismatches;
+    unsigned long unanswered;
+    unsigned long pushFrames;   /* Unsolicited frames sent while the request was pending */
+} benchRequest_T;
+
+/* Simulated transport state */
+static const std::vector<uint8_t> *pendingRequest;
+static size_t pendingIndex;
+static std::vector<uint8_t> response;
+static bool responseSent;
+static bool inServer;           /* Set while server() runs, sends in between answer the pending request */
+static unsigned long pushFrames;
+
+extern "C" {
+    
+    void __real_server(uint8_T *payloadBufferRx, uint8_T *payloadBufferTx, uint8_T background);
+    
+    void __wrap_server(uint8_T *payloadBufferRx, uint8_T *payloadBufferTx, uint8_T background)
+    {
+        inServer = true;
+        __real_server(payloadBufferRx, payloadBufferTx, background);
+        inServer = false;
+    }
+
+    int rtIOStreamOpen(int argc, void *argv[])
+    {
+        (void)argc;
+        (void)argv;
+        return RTIOSTREAM_NO_ERROR;
+    }
+
+    int rtIOStreamSend(int streamID, const void *src, size_t size, size_t *sizeSent)
+    {
+        (void)streamID;
+        const uint8_t *bytes = (const uint8_t *)src;
+        if (inServer)
+        {
+            response.insert(response.end(), bytes, bytes + size);
+            responseSent = true;
+        }
+        else if ((size == 1) && (bytes[0] >= EDGE_EVENT_FRAME_START) && (bytes[0] <= ANALOG_TRIGGER_FRAME_START))
+        {
+            /* sendPushFrame writes the start byte on its own */
+            pushFrames++;
+        }
+        *sizeSent = size;
+        return RTIOSTREAM_NO_ERROR;
+    }
+
+    int rtIOStreamRecv(int streamID, void *dst, size_t size, size_t *sizeRecvd)
+    {
+        (void)streamID;
+        size_t n = 0;
+        if (pendingRequest != NULL)
+        {
+            n = std::min(size, pendingRequest->size() - pendingIndex);
+            memcpy(dst, pendingRequest->data() + pendingIndex, n);
+            pendingIndex += n;
+        }
+        *sizeRecvd = n;
+        return RTIOSTREAM_NO_ERROR;
+    }
+
+    int rtIOStreamClose(int streamID)
+    {
+        (void)streamID;
+        return RTIOSTREAM_NO_ERROR;
+    }
+}
+
+static double nowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec * 1e-3;
+}
+
+static bool parseHex(const char *text, std::vector<uint8_t> &bytes)
+{
+    size_t length = strlen(text);
+    if (length % 2 != 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i += 2)
+    {
+        unsigned value;
+        if (sscanf(text + i, "%2x", &value) != 1)
+        {
+            return false;
+        }
+        bytes.push_back((uint8_t)value);
+    }
+    return true;
+}
+
+static bool loadMix(const char *path, std::vector<benchRequest_T> &mix)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    char line[4096];
+    unsigned lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64], request[2048], expected[2048] = "";
+        unsigned weight;
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';
+        }
+        int fields = sscanf(line, "%u %63s %2047s %2047s", &weight, name, request, expected);
+        if (fields <= 0)
+        {
+            continue;
+        }
+        benchRequest_T entry;
+        entry.name = name;
+        entry.weight = weight;
+        entry.responseBytes = 0;
+        entry.mismatches = 0;
+        entry.unanswered = 0;
+        entry.pushFrames = 0;
+        if (fields < 3 || !parseHex(request, entry.request) || !parseHex(expected, entry.expected))
+        {
+            fprintf(stderr, "%s:%u: expected <weight> <name> <request hex> [<response hex>]\n", path, lineNumber);
+            fclose(file);
+            return false;
+        }
+        if (weight > 0)
+        {
+            mix.push_back(entry);
+        }
+    }
+    fclose(file);
+    return !mix.empty();
+}
+
+/* Runs one request through the server, returns its cost in us or -1 when no
+ * response came back */
+static double runRequest(benchRequest_T &entry)
+{
+    pendingRequest = &entry.request;
+    pendingIndex = 0;
+    response.clear();
+    responseSent = false;
+    pushFrames = 0;
+
+    double start = nowUs();
+    unsigned loops = 0;
+    while (!responseSent && loops++ < BENCH_MAX_LOOPS)
+    {
+        loop();
+    }
+    double cost = nowUs() - start;
+    pendingRequest = NULL;
+    entry.pushFrames += pushFrames;
+
+    if (!responseSent)
+    {
+        entry.unanswered++;
+        return -1.0;
+    }
+    entry.responseBytes = response.size();
+    if (!entry.expected.empty() && response != entry.expected)
+    {
+        entry.mismatches++;
+    }
+    return cost;
+}
+
+/* Link time for one packet of the given size in one direction */
+static double linkUs(const linkModel_T &link, size_t bytes)
+{
+    double us = link.packetOverheadUs;
+    if (link.bytesPerUs > 0.0)
+    {
+        us += (double)bytes / link.bytesPerUs;
+    }
+    if (link.frameBytes > 0)
+    {
+        unsigned frames = (unsigned)((bytes + link.frameBytes - 1) / link.frameBytes);
+        unsigned intervals = (frames + link.framesPerInterval - 1) / link.framesPerInterval;
+        us += (double)intervals * link.intervalUs;
+    }
+    return us;
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = (size_t)ceil(p * (double)sorted.size());
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+/* Baseline lines are "<name> <loopback p99 us>" */
+static int checkBaseline(const char *path, const std::vector<benchRequest_T> &mix,
+                         const std::vector<double> &p99, double tolerance)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    int failed = 0;
+    char name[64];
+    double baseline;
+    while (fscanf(file, "%63s %lf", name, &baseline) == 2)
+    {
+        for (size_t i = 0; i < mix.size(); i++)
+        {
+            if (mix[i].name == name && p99[i] > baseline * (1.0 + tolerance / 100.0))
+            {
+                printf("REGRESSION %s: p99 %.2f us, baseline %.2f us\n", name, p99[i], baseline);
+                failed = 1;
+            }
+        }
+    }
+    fclose(file);
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mixPath = NULL;
+    const char *resultsPath = NULL;
+    const char *baselinePath = NULL;
+    unsigned long numRequests = 10000;
+    unsigned seed = 1;
+    double tolerance = 20.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:n:s:o:g:x:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mixPath = optarg; break;
+            case 'n': numRequests = strtoul(optarg, NULL, 0); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'o': resultsPath = optarg; break;
+            case 'g': baselinePath = optarg; break;
+            case 'x': tolerance = atof(optarg); break;
+            default: mixPath = NULL; optind = argc; break;
+        }
+    }
+    std::vector<benchRequest_T> mix;
+    if (mixPath == NULL || numRequests == 0)
+    {
+        fprintf(stderr, "usage: %s -m mix [-n requests] [-s seed] [-o results] [-g baseline [-x percent]]\n", argv[0]);
+        return 2;
+    }
+    if (!loadMix(mixPath, mix))
+    {
+        return 2;
+    }
+
+    unsigned long totalWeight = 0;
+    for (size_t i = 0; i < mix.size(); i++)
+    {
+        totalWeight += mix[i].weight;
+    }
+
+    /* The mix is drawn with a fixed seed so that runs are comparable */
+    srand(seed);
+    setup();
+    for (unsigned long n = 0; n < BENCH_WARMUP_REQUESTS + numRequests; n++)
+    {
+        unsigned long pick = (unsigned long)rand() % totalWeight;
+        size_t i = 0;
+        while (pick >= mix[i].weight)
+        {
+            pick -= mix[i].weight;
+            i++;
+        }
+        double cost = runRequest(mix[i]);
+        if (n >= BENCH_WARMUP_REQUESTS && cost >= 0.0)
+        {
+            mix[i].serverUs.push_back(cost);
+        }
+    }
+
+    printf("%-10s %-9s %-20s %8s %10s %10s %10s %10s\n", "transport", "latency", "request", "count", "p50 us", "p99 us", "p999 us", "req/s");
+    std::vector<double> loopbackP99(mix.size(), 0.0);
+    for (size_t t = 0; t < NUM_LINK_MODELS; t++)
+    {
+        for (size_t i = 0; i < mix.size(); i++)
+        {
+            benchRequest_T &entry = mix[i];
+            if (entry.serverUs.empty())
+            {
+                continue;
+            }
+            /* Request and response sizes are fixed per entry, the link time is
+             * a constant offset on top of the measured server cost */
+            double link = linkUs(linkModels[t], entry.request.size()) + linkUs(linkModels[t], entry.responseBytes);
+            std::vector<double> latency(entry.serverUs);
+            double sum = 0.0;
+            for (size_t k = 0; k < latency.size(); k++)
+            {
+                latency[k] += link;
+                sum += latency[k];
+            }
+            std::sort(latency.begin(), latency.end());
+            double p99 = percentile(latency, 0.99);
+            if (t == 0)
+            {
+                loopbackP99[i] = p99;
+            }
+            printf("%-10s %-9s %-20s %8zu %10.2f %10.2f %10.2f %10.1f\n", linkModels[t].name,
+                   linkModels[t].modeled ? "modeled" : "measured", entry.name.c_str(),
+                   latency.size(), percentile(latency, 0.5), p99, percentile(latency, 0.999),
+                   1e6 * (double)latency.size() / sum);
+        }
+    }
+
+    int status = 0;
+    for (size_t i = 0; i < mix.size(); i++)
+    {
+        if (mix[i].unanswered || mix[i].mismatches)
+        {
+            printf("%s: %lu unanswered, %lu responses differ from the mix\n",
+                   mix[i].name.c_str(), mix[i].unanswered, mix[i].mismatches);
+        }
+        if (mix[i].pushFrames)
+        {
+            printf("%s: %lu unsolicited frames left out of the responses\n", mix[i].name.c_str(), mix[i].pushFrames);
+        }
+    }
+    if (resultsPath != NULL)
+    {
+        FILE *file = fopen(resultsPath, "w");
+        if (file == NULL)
+        {
+            perror(resultsPath);
+            return 2;
+        }
+        for (size_t i = 0; i < mix.size(); i++)
+        {
+            fprintf(file, "%s %.2f\n", mix[i].name.c_str(), loopbackP99[i]);
+        }
+        fclose(file);
+    }
+    if (baselinePath != NULL)
+    {
+        status = checkBaseline(baselinePath, mix, loopbackP99, tolerance);
+    }
+    return status;
+}
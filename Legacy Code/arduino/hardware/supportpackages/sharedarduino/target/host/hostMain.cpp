@@ -0,0 +1,202 @@
+/**
+ * @file hostMain.cpp
+ *
+ * Entry point of the Linux host build. Connects Serial to a pty or a TCP
+ * socket, then runs setup() and loop() like the Arduino core does. On exit it
+ * prints the loop count, the responses sent and the CPU time the server used,
+ * so that request throughput and firmware cost can be compared across changes.
+ *
+ * Usage: ioserver_host [-t port] [-v] [-n loops] [-c file]
+ *   -t port   listen on 127.0.0.1:port instead of opening a pty
+ *   -v        run on the virtual clock instead of CLOCK_MONOTONIC
+ *   -n loops  stop after this many calls to loop()
+ *   -c file   append every request and its response to file, in the
+ *             request mix format ioserver_bench reads
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "Arduino.h"
+
+void setup(void);
+void loop(void);
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stopRequested = 1;
+}
+
+static double elapsed(clockid_t id, const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(id, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static int openPty(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    printf("ioserver_host: serial port %s\n", ptsname(fd));
+    fflush(stdout);
+    return fd;
+}
+
+static int openListener(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0)
+    {
+        perror("ioserver_host: listen");
+        return -1;
+    }
+    printf("ioserver_host: listening on 127.0.0.1:%d\n", port);
+    fflush(stdout);
+    return fd;
+}
+
+/* Blocks until a client connects, returns -1 when interrupted */
+static int acceptClient(int listener)
+{
+    int fd = -1;
+    while (!stopRequested && fd < 0)
+    {
+        fd = accept(listener, NULL, NULL);
+        if (fd < 0 && errno != EINTR)
+        {
+            perror("ioserver_host: accept");
+            return -1;
+        }
+    }
+    if (fd >= 0)
+    {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    int port = 0;
+    unsigned long maxLoops = 0;
+    FILE *captureFile = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:vn:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                port = atoi(optarg);
+                break;
+            case 'v':
+                hostSetClockMode(HOST_CLOCK_VIRTUAL);
+                break;
+            case 'n':
+                maxLoops = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                captureFile = fopen(optarg, "a");
+                if (captureFile == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                Serial.capture(captureFile);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t port] [-v] [-n loops] [-c file]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    /* No SA_RESTART, so that a blocking accept() returns on Ctrl-C */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = -1;
+    if (port > 0)
+    {
+        listener = openListener(port);
+        if (listener < 0)
+        {
+            return 1;
+        }
+        Serial.attach(acceptClient(listener));
+    }
+    else
+    {
+        int fd = openPty();
+        if (fd < 0)
+        {
+            return 1;
+        }
+        Serial.attach(fd);
+    }
+
+    struct timespec wallStart, cpuStart;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+
+    unsigned long loops = 0;
+    setup();
+    while (!stopRequested && (maxLoops == 0 || loops < maxLoops))
+    {
+        loop();
+        loops++;
+        if (listener >= 0 && Serial.hungUp())
+        {
+            close(Serial.fd());
+            Serial.attach(acceptClient(listener));
+        }
+    }
+
+    double wall = elapsed(CLOCK_MONOTONIC, &wallStart);
+    double cpu = elapsed(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+    printf("ioserver_host: %lu loops, %lu responses, %lu bytes in, %lu bytes out\n",
+           loops, Serial.writes, Serial.bytesIn, Serial.bytesOut);
+    printf("ioserver_host: %.3f s wall, %.3f s cpu, %.1f responses/s, %.2f us cpu/response\n",
+           wall, cpu, (wall > 0.0) ? Serial.writes / wall : 0.0,
+           (Serial.writes > 0) ? cpu * 1e6 / Serial.writes : 0.0);
+    if (captureFile != NULL)
+    {
+        Serial.flushCapture();
+        fclose(captureFile);
+    }
+    return 0;
+}
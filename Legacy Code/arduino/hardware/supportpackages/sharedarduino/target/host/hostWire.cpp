@@ -0,0 +1,121 @@
+/**
+ * @file hostWire.cpp
+ *
+ * Virtual I2C bus behind the host Wire.h.
+ *
+ */
+#include "Wire.h"
+
+typedef struct
+{
+    uint8_t address;
+    uint8_t pointer;
+    uint8_t registers[256];
+} hostI2CDevice_T;
+
+static hostI2CDevice_T devices[HOST_I2C_MAX_DEVICES];
+static uint8_t numDevices;
+
+static hostI2CDevice_T* findDevice(uint8_t address)
+{
+    for (uint8_t i = 0; i < numDevices; i++)
+    {
+        if (devices[i].address == address)
+        {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+uint8_t* hostI2CAddDevice(uint8_t address)
+{
+    hostI2CDevice_T* device = findDevice(address);
+    if (device == NULL)
+    {
+        if (numDevices >= HOST_I2C_MAX_DEVICES)
+        {
+            return NULL;
+        }
+        device = &devices[numDevices++];
+        device->address = address;
+        device->pointer = 0;
+    }
+    return device->registers;
+}
+
+TwoWire Wire;
+
+TwoWire::TwoWire() : rxIndex(0), rxLength(0), txLength(0), txAddress(0), transmitting(false)
+{
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    transmitting = true;
+    txAddress = address;
+    txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (!transmitting || (txLength >= BUFFER_LENGTH))
+    {
+        return 0;
+    }
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    size_t n = 0;
+    while ((n < quantity) && write(data[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+/* Same status codes as the AVR core: 0 success, 2 address NACK */
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+    (void)sendStop;
+    hostI2CDevice_T* device = findDevice(txAddress);
+    transmitting = false;
+    if (device == NULL)
+    {
+        return 2;
+    }
+    if (txLength > 0)
+    {
+        device->pointer = txBuffer[0];
+        for (uint8_t i = 1; i < txLength; i++)
+        {
+            device->registers[device->pointer++] = txBuffer[i];
+        }
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    (void)sendStop;
+    hostI2CDevice_T* device = findDevice(address);
+    rxIndex = 0;
+    rxLength = 0;
+    if (device == NULL)
+    {
+        return 0;
+    }
+    if (quantity > BUFFER_LENGTH)
+    {
+        quantity = BUFFER_LENGTH;
+    }
+    for (uint8_t i = 0; i < quantity; i++)
+    {
+        rxBuffer[i] = device->registers[device->pointer++];
+    }
+    rxLength = quantity;
+    return quantity;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file peripheralIncludes.h
+ *
+ * Server configuration for the Linux host build, in place of the header
+ * Utility.m generates for a board. It mirrors an Uno class board with the
+ * I2C, SPI, Servo, RotaryEncoder, Ultrasonic and ShiftRegister libraries.
+ *
+ */
+#ifndef PERIPHERALINCLUDES_H_
+#define PERIPHERALINCLUDES_H_
+
+#define INCLUDE_FUNCTION_MACROS
+#define MAX_PACKET_SIZE 160
+#define IO_CUSTOM_ENABLE 1
+#define IO_STANDARD_ENABLE 1
+#if IO_STANDARD_ENABLE
+
+#define IO_STANDARD_DIGITALIO 1
+#define IO_SPI_MODULES_MAX 1
+#define IO_CS_BY_SPI_DRIVER 1
+#define IO_I2C_MODULES_MAX 1
+#define IO_STANDARD_ANALOGINPUT 1
+#define IO_ANALOGINPUT_MODULES_MAX 16
+#define IO_STANDARD_PWM 1
+#define IO_PWM_MODULES_MAX 16
+#define SOFT_REALTIME_SCHEDULING
+#define IO_DIGITALIO_MODULES_MAX 20
+#define IO_STANDARD_I2C 1
+#define IO_STANDARD_SPI 1
+#define IO_CUSTOM_SERVO 1
+#define IO_CUSTOM_ROTARYENCODER 1
+#define IO_CUSTOM_ULTRASONIC 1
+#define IO_CUSTOM_SHIFTREGISTER 1
+#endif
+#define LTC_BAREMETAL_HARDWARE
+
+#endif
@@ -7,11 +7,44 @@
 #include "Arduino.h"
 #endif
 #include "IO_peripheralInclude.h"
+#include "analogConfigArduino.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
     
+    /* The settings come from the build, so they are written once */
+    static boolean_T analogConfigApplied = 0;
+    
+    void applyAnalogConfig(void)
+    {
+        if (analogConfigApplied)
+        {
+            return;
+        }
+#if ANALOG_READ_BITS != 10
+        /* By default ADC resolution is 10-bits, changing it to 12-bits for ARM and ESP32 boards */
+        analogReadResolution(ANALOG_READ_BITS);
+#endif
+#ifdef MW_AREF
+        /* Call Microcontroller specific MACRO values to set analog reference */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega2560__)
+        {
+            /*'Uno','Nano3','ProMini328_3V','ProMini328_5V','DigitalSandbox','Leonardo','Micro','Mega2560','MegaADK'*/
+            analogReference(MW_AREF);
+        }
+#elif defined(ARDUINO_ARCH_SAMD)
+        {
+            /*'MKR1000','MKR1010','MKRZero','Nano33IoT*/
+            /*Due supports only Default analog reference mode and hence its not being set*/
+            /*Type casting is being done as per definition of macros for SAMD boards*/
+            analogReference(static_cast<eAnalogReference>(MW_AREF));
+        }
+#endif
+#endif
+        analogConfigApplied = 1;
+    }
+    
     /* Create AnalogIn group with Channels and Conversion time */
     MW_Handle_Type MW_AnalogInSingle_Open(uint32_T Pin)
     {
@@ -21,6 +54,8 @@ extern "C" {
         if((uint8_T)Pin <= IO_ANALOGINPUT_MODULES_MAX)
         {
             pinMode((uint8_T)Pin, INPUT);
+            /* Done here so that reads only convert */
+            applyAnalogConfig();
 #if DEBUG_FLAG == 2
             DebugMsg.debugMsgID = DEBUGOPENDIGITALPIN;
             DebugMsg.args[index++]=(uint8_T)Pin;
@@ -75,35 +110,8 @@ extern "C" {
         uint8_T pin;
 #if DEBUG_FLAG == 2
         uint8_T index=0;
-#endif
-#if defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040) || defined(ARDUINO_ARCH_RENESAS_UNO)
-        /* By default ADC resolution is 10-bits, changing it to 12-bits for ARM boards */
-        analogReadResolution(12);
 #endif
         pin = *((uint8_T*)(&AnalogInHandle)) - 1;
-#ifdef MW_AREF        
-        /* To avoid setting analog reference, everytime readVoltage command is called aref_call variable is used */
-       static boolean_T aref_call = 'T';
-        
-       if (aref_call == 'T')
-       {
-            /* Call Microcontroller specific MACRO values to set analog reference */
-#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega2560__)
-            {
-                /*'Uno','Nano3','ProMini328_3V','ProMini328_5V','DigitalSandbox','Leonardo','Micro','Mega2560','MegaADK'*/
-               analogReference(MW_AREF);
-            }
-#elif defined(ARDUINO_ARCH_SAMD)
-            {
-                /*'MKR1000','MKR1010','MKRZero','Nano33IoT*/
-                /*Due supports only Default analog reference mode and hence its not being set*/
-                /*Type casting is being done as per definition of macros for SAMD boards*/
-               analogReference(static_cast<eAnalogReference>(MW_AREF));
-            }
-#endif
-           aref_call = 'F';
-       }
-#endif
         
         counts = analogRead(pin);
 #if DEBUG_FLAG == 2
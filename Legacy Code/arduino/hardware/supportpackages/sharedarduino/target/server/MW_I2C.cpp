@@ -6,9 +6,156 @@
 #include "IO_peripheralInclude.h"
 #include "MW_I2C.h"
 #include "Wire.h"
+#include "i2cQueueArduino.h"
 
 #if IO_STANDARD_I2C
 
+/* Bytes the Wire buffers of the core take in one transfer. Longer reads are
+ * split into chunks of this size, joined by repeated starts. Longer writes
+ * are refused, see i2cWrite */
+#if !defined(I2C_CHUNK_SIZE)
+#if defined(BUFFER_LENGTH) && (BUFFER_LENGTH < 256)
+#define I2C_CHUNK_SIZE BUFFER_LENGTH
+#elif defined(I2C_BUFFER_LENGTH) && (I2C_BUFFER_LENGTH < 256)
+#define I2C_CHUNK_SIZE I2C_BUFFER_LENGTH
+#else
+#define I2C_CHUNK_SIZE 32
+#endif
+#endif
+
+/* Read a transfer of any length. Every chunk but the last ends in a repeated
+ * start, so that the device carries on from where the previous chunk stopped */
+template <class wire_T>
+static MW_I2C_Status_Type i2cReadChunks(wire_T& wire, uint8_T bus, uint8_T address, uint8_T * data, uint32_T DataLength, bool sendstop)
+{
+    uint32_T offset = 0;
+    uint8_T numBytes, status;
+    bool stop;
+#if DEBUG_FLAG == 2
+    uint8_T index;
+#endif
+    while (offset < DataLength)
+    {
+        numBytes = (DataLength - offset > I2C_CHUNK_SIZE) ? I2C_CHUNK_SIZE : (uint8_T)(DataLength - offset);
+        stop = (offset + numBytes == DataLength) ? sendstop : false;
+        status = wire.requestFrom(address, numBytes, stop);
+#if DEBUG_FLAG == 2
+        index=0;
+        DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CREQUESTFROMAVR : DEBUGI2CREQUESTFROMARM;
+        DebugMsg.args[index++]=address;
+        DebugMsg.args[index++]=numBytes;
+        DebugMsg.args[index++]=stop;
+        DebugMsg.args[index++]=status;
+        DebugMsg.argNum = index;
+        sendDebugPackets();
+#endif
+        if(status != numBytes)
+        {
+            return MW_I2C_BUS_ERROR;
+        }
+        /* The bytes are already in the Wire buffer, copy them in one go.
+         * Stream::readBytes would wait on a timeout for each byte */
+        for(uint8_T i = 0; i < numBytes; ++i)
+        {
+            data[offset + i] = (uint8_T)wire.read();
+        }
+#if DEBUG_FLAG == 2
+        for(uint8_T i = 0; i < numBytes; ++i)
+        {
+            index=0;
+            DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CREADFROMAVR : DEBUGI2CREADFROMARM;
+            DebugMsg.args[index++]=data[offset + i];
+            DebugMsg.argNum = index;
+            sendDebugPackets();
+        }
+#endif
+        offset += numBytes;
+    }
+    return MW_I2C_SUCCESS;
+}
+
+/* Write in a single transmission. A write cannot be split like a read: a
+ * device that takes the first byte of a write as its register address would
+ * take the first byte of every further transmission as a new address. So a
+ * write longer than the Wire buffer, which the core would cut short, is
+ * refused before it reaches the bus. A write with no data still addresses
+ * the device */
+template <class wire_T>
+static MW_I2C_Status_Type i2cWrite(wire_T& wire, uint8_T bus, uint8_T address, uint8_T * data, uint32_T DataLength, bool sendstop)
+{
+    uint8_T numBytes, status, n = 0;
+#if DEBUG_FLAG == 2
+    uint8_T index;
+#endif
+    if (DataLength > I2C_CHUNK_SIZE)
+    {
+        return MW_I2C_BUS_ERROR;
+    }
+    numBytes = (uint8_T)DataLength;
+    wire.beginTransmission(address);
+#if DEBUG_FLAG == 2
+    index=0;
+    DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CBEGINTRANSMISSIONAVR : DEBUGI2CBEGINTRANSMISSIONARM;
+    DebugMsg.args[index++]=address;
+    DebugMsg.argNum = index;
+    sendDebugPackets();
+#endif
+    if(numBytes > 0)
+    {
+        n = (uint8_T)wire.write(data, numBytes);
+#if DEBUG_FLAG == 2
+        index=0;
+        DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CWRITEAVR : DEBUGI2CWRITEARM;
+        DebugMsg.args[index++]=data[0];
+        DebugMsg.args[index++]=1;// one byte address
+        DebugMsg.argNum = index;
+        sendDebugPackets();
+#endif
+    }
+#if DEBUG_FLAG == 2
+    if(numBytes>1)
+    {
+        index = 0;
+        switch (numBytes)
+        {
+            case 2:
+                DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CWRITEAVR1DATA : DEBUGI2CWRITEARM1DATA;
+                DebugMsg.args[index++] = data[1];
+                break;
+            case 3:
+                DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CWRITEAVR2DATA : DEBUGI2CWRITEARM2DATA;
+                DebugMsg.args[index++] = data[1];
+                DebugMsg.args[index++] = data[2];
+                break;
+            default:
+                DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CWRITEAVR3DATA : DEBUGI2CWRITEARM3DATA;
+                DebugMsg.args[index++] = data[1];
+                DebugMsg.args[index++] = data[2];
+                DebugMsg.args[index++] = data[3];
+        }
+        DebugMsg.args[index++] = numBytes-1;
+        DebugMsg.args[index++] = n-1;
+        DebugMsg.argNum = index;
+        sendDebugPackets();
+    }
+#endif
+    status = wire.endTransmission(sendstop);
+#if DEBUG_FLAG == 2
+    index=0;
+    DebugMsg.debugMsgID=(bus == 0) ? DEBUGI2CENDTRANSMISSIONAVR : DEBUGI2CENDTRANSMISSIONARM;
+    DebugMsg.args[index++]=sendstop;
+    DebugMsg.args[index++]=status;
+    DebugMsg.argNum = index;
+    sendDebugPackets();
+#endif
+    if((status != 0) || (n != numBytes))
+    {
+        /*TODO : check what error should I send */
+        return MW_I2C_BUS_ERROR;
+    }
+    return MW_I2C_SUCCESS;
+}
+
 bool hasBegin[IO_I2C_MODULES_MAX] = {false};
 #ifdef __cplusplus
 extern "C" {
@@ -112,91 +259,21 @@ extern "C" {
     {
         uint8_T bus = *((uint8_T*)(&I2CModuleHandle)) - 1;
         uint8_T address  = (uint8_T)SlaveAddress;
-        uint8_T numBytes = (uint8_T)DataLength; /* numBytes can only be a byte according to requestFrom API prototype */
-        uint8_T status;
-#if DEBUG_FLAG == 2
-        uint8_T index=0;
-#endif
-        bool sendstop;
-        if (RepeatedStart == 0)
-        {
-            sendstop = true;
-        }
-        else
-        {
-            sendstop = false;
-        }
-        MW_I2C_Status_Type RequestFromStatus;
+        bool sendstop = (RepeatedStart == 0);
+        
+        /* A queued transfer part way through a read holds the bus */
+        finishI2CTransfer();
         if(bus == 0)
         {
-            status = Wire.requestFrom(address, (uint8_T)numBytes,sendstop);
-#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CREQUESTFROMAVR;
-            DebugMsg.args[index++]=address;
-            DebugMsg.args[index++]=numBytes;
-            DebugMsg.args[index++]=sendstop;
-            DebugMsg.args[index++]=status;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-#endif
-            if(status != numBytes)
-            {
-                RequestFromStatus = MW_I2C_BUS_ERROR;
-            }
-            else
-            {
-                RequestFromStatus = MW_I2C_SUCCESS;
-                for(int i = 0; i < numBytes; ++i)
-                {
-                    data[i] = Wire.read();
-#if DEBUG_FLAG == 2
-                    index=0;
-                    DebugMsg.debugMsgID=DEBUGI2CREADFROMAVR;
-                    DebugMsg.args[index++]=data[i];
-                    DebugMsg.argNum = index;
-                    sendDebugPackets();
-#endif
-                }
-            }
-            
+            return i2cReadChunks(Wire, bus, address, data, DataLength, sendstop);
         }
+#if defined ARDUINO_ARCH_SAM || defined ARDUINO_ARCH_NRF52840
         else
         {
-#if defined ARDUINO_ARCH_SAM || defined ARDUINO_ARCH_NRF52840
-            status = Wire1.requestFrom(address, (uint8_T)numBytes,sendstop);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID= DEBUGI2CREQUESTFROMARM;
-            DebugMsg.args[index++]=address;
-            DebugMsg.args[index++]=numBytes;
-            DebugMsg.args[index++]=sendstop;
-            DebugMsg.args[index++]=status;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
-            if(status != numBytes)
-            {
-                RequestFromStatus = MW_I2C_BUS_ERROR;
-            }
-            else
-            {
-                RequestFromStatus = MW_I2C_SUCCESS;
-                for(int i = 0; i < numBytes; ++i)
-                {
-                    data[i] = Wire1.read();
-	#if DEBUG_FLAG == 2
-                    index=0;
-                    DebugMsg.debugMsgID=DEBUGI2CREADFROMARM;
-                    DebugMsg.args[index++]=data[i];
-                    DebugMsg.argNum = index;
-                    sendDebugPackets();
-	#endif
-                }
-            }
-#endif
+            return i2cReadChunks(Wire1, bus, address, data, DataLength, sendstop);
         }
-        return RequestFromStatus;
+#endif
+        return MW_I2C_BUS_ERROR;
     }
     
     /* Send the data from master to a specified slave */
@@ -204,153 +281,22 @@ extern "C" {
     {
         uint8_T bus = *((uint8_T*)(&I2CModuleHandle)) - 1;
         uint8_T address  = (uint8_T)SlaveAddress;
-        uint8_T numBytes = DataLength; /* numBytes can only be a byte according to requestFrom API prototype */
-        uint8_T status;
-        uint8_T n=0;
-        bool sendstop;
-	#if DEBUG_FLAG == 2
-        uint8_T index=0;
-	#endif
-        if (RepeatedStart == 0)
-        {
-            sendstop = true;
-        }
-        else
-        {
-            sendstop = false;
-        }
+        bool sendstop = (RepeatedStart == 0);
+        
+        /* A queued transfer part way through a read holds the bus */
+        finishI2CTransfer();
         if(bus == 0)
         {
-            Wire.beginTransmission(address);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CBEGINTRANSMISSIONAVR;
-            DebugMsg.args[index++]=address;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
-            if(numBytes > 0)
-            {
-                n = Wire.write(data, numBytes);
-    #if DEBUG_FLAG == 2
-                index=0;
-                DebugMsg.debugMsgID=DEBUGI2CWRITEAVR;
-                DebugMsg.args[index++]=data[0];
-                DebugMsg.args[index++]=1;// one byte address
-                DebugMsg.argNum = index;
-                sendDebugPackets();
-    #endif
-            }
-    #if DEBUG_FLAG == 2       
-            if(numBytes>1)
-            {
-                index = 0;
-                switch (numBytes)
-                {
-                    case 2:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEAVR1DATA;
-                        DebugMsg.args[index++] = data[1];
-                        break;
-                    case 3:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEAVR2DATA;
-                        DebugMsg.args[index++] = data[1];
-                        DebugMsg.args[index++] = data[2];
-                        break;
-                    default:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEAVR3DATA;
-                        DebugMsg.args[index++] = data[1];
-                        DebugMsg.args[index++] = data[2];
-                        DebugMsg.args[index++] = data[3];
-                }
-                DebugMsg.args[index++] = numBytes-1;
-                DebugMsg.args[index++] = n-1;
-                DebugMsg.argNum = index;
-                sendDebugPackets();
-            }
-        #endif
-            status = Wire.endTransmission(sendstop);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CENDTRANSMISSIONAVR;
-            DebugMsg.args[index++]=sendstop;
-            DebugMsg.args[index++]=status;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
+            return i2cWrite(Wire, bus, address, data, DataLength, sendstop);
         }
 #if defined ARDUINO_ARCH_SAM || defined ARDUINO_ARCH_NRF52840
         else
         {
             /* For now, only bus 0 and 1 are supported */
-
-            Wire1.beginTransmission(address);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CBEGINTRANSMISSIONARM;
-            DebugMsg.args[index++]=address;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
-            if(numBytes > 0)
-            {
-            n = Wire1.write(data, numBytes);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CWRITEARM;
-            DebugMsg.args[index++]=data[0];
-            DebugMsg.args[index++]=1;// one byte
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
-            }
-            
-	#if DEBUG_FLAG == 2
-            if(numBytes>1)
-            {
-                index = 0;
-                switch (numBytes)
-                {
-                    case 2:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEARM1DATA;
-                        DebugMsg.args[index++] = data[1];
-                        break;
-                    case 3:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEARM2DATA;
-                        DebugMsg.args[index++] = data[1];
-                        DebugMsg.args[index++] = data[2];
-                        break;
-                    default:
-                        DebugMsg.debugMsgID=DEBUGI2CWRITEARM3DATA;
-                        DebugMsg.args[index++] = data[1];
-                        DebugMsg.args[index++] = data[2];
-                        DebugMsg.args[index++] = data[3];
-                }
-                DebugMsg.args[index++] = numBytes-1;
-                DebugMsg.args[index++] = n-1;
-                DebugMsg.argNum = index;
-                sendDebugPackets();
-            }
-	#endif
-            status = Wire1.endTransmission(sendstop);
-	#if DEBUG_FLAG == 2
-            index=0;
-            DebugMsg.debugMsgID=DEBUGI2CENDTRANSMISSIONARM;
-            DebugMsg.args[index++]=sendstop;
-            DebugMsg.args[index++]=status;
-            DebugMsg.argNum = index;
-            sendDebugPackets();
-	#endif
+            return i2cWrite(Wire1, bus, address, data, DataLength, sendstop);
         }
 #endif
-        if(status == 0)
-        {
-            return MW_I2C_SUCCESS;
-        }
-        else
-        {
-            /*TODO : check what error should I send */
-            return  MW_I2C_BUS_ERROR;
-        }
+        return MW_I2C_BUS_ERROR;
     }
     
     /* Read data on the slave device from a Master. Since, Arduino has no usecase to be used as slave leaving it empty  */
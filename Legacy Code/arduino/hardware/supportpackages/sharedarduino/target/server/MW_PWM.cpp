@@ -6,44 +6,68 @@
 #include "Arduino.h"
 #endif
 #include "IO_peripheralInclude.h"
+#include "eventJournalArduino.h"
+#include "timerPwmArduino.h"
+#include "pwmWaveformArduino.h"
 #if defined (ESP_H)
-    #include "PWMChannel.cpp"
+    #include "PWMChannel.h"
 #endif
 
 #if defined(ARDUINO_ARCH_RENESAS_UNO)
+#include <new>
 #include "pwm.h"
 
 // Define the number of PWM pins
 #define NUM_PWM_PINS 6
 
-// Create an array of PwmOut objects
-static PwmOut* pwmObjects[NUM_PWM_PINS];
-static uint8_T pwmPinIndex[NUM_PWM_PINS];
-static uint8_T pwmPinCounter = 0;
+/* The PwmOut objects are built in place in fixed slots when a pin is opened
+ * with a frequency, so that reopening pins never goes to the heap */
+alignas(PwmOut) static uint8_T pwmObjects[NUM_PWM_PINS][sizeof(PwmOut)];
+static uint8_T freePwmSlots = (1 << NUM_PWM_PINS) - 1;
 
+/* Slot + 1 of each pin, 0 for none */
+static uint8_T pwmSlotOfPin[IO_PWM_MODULES_MAX + 1];
 
-// Create a PwmOut object for a specified pin and add it to the array
-void createPwmObject(int pin) {
-    pwmObjects[pwmPinCounter] = new PwmOut(pin);
-    pwmPinIndex[pwmPinCounter] = (uint8_T)pin;
-    pwmPinCounter++;
-    if (pwmPinCounter>= NUM_PWM_PINS) {
-        // A safeguard to avoid accidental out-of-bound access
-        pwmPinCounter = NUM_PWM_PINS-1;
+
+// PwmOut object of a pin, or NULL when the pin uses analogWrite
+static PwmOut* getPwmObject(uint8_T pin) {
+    if ((pin > IO_PWM_MODULES_MAX) || (pwmSlotOfPin[pin] == 0)) {
+        return NULL;
     }
+    return reinterpret_cast<PwmOut*>(pwmObjects[pwmSlotOfPin[pin] - 1]);
 }
 
 
-int getIndexForPWMPin(int pin) {
-    int i=0;
-    int idx = 0;
-    for (i=0;i<NUM_PWM_PINS;i++) {
-        if (pin==pwmPinIndex[i]) {
-            idx = i;
-            break;
-        }
+// Stop the PwmOut object of a pin and give its slot back
+static void releasePwmObject(uint8_T pin) {
+    PwmOut* pwm = getPwmObject(pin);
+    if (pwm != NULL) {
+        pwm->end();
+        pwm->~PwmOut();
+        freePwmSlots |= (uint8_T)(1 << (pwmSlotOfPin[pin] - 1));
+        pwmSlotOfPin[pin] = 0;
+    }
+}
+
+
+// Run a pin from a PwmOut object at a frequency. Returns NULL when every slot
+// is taken or the pin has no free timer channel
+static PwmOut* createPwmObject(uint8_T pin, real_T frequency) {
+    uint8_T slot;
+    PwmOut* pwm;
+    releasePwmObject(pin);
+    if (freePwmSlots == 0) {
+        return NULL;
+    }
+    slot = (uint8_T)__builtin_ctz(freePwmSlots);
+    pwm = new (pwmObjects[slot]) PwmOut(pin);
+    if (!pwm->begin((float)frequency, 0.0f)) {
+        pwm->~PwmOut();
+        return NULL;
     }
-    return idx;
+    freePwmSlots &= (uint8_T)~(1 << slot);
+    pwmSlotOfPin[pin] = slot + 1;
+    return pwm;
 }
 
 #endif
@@ -58,6 +82,14 @@ extern "C" {
     bool PWMChannels[16] = {0};
     const uint8_T numChannels = 16;
 #endif*/
+    /* Set for each pin between MW_PWM_Open and MW_PWM_Close */
+    static uint8_T pwmPinOpen[IO_PWM_MODULES_MAX + 1];
+    
+    uint8_T pwmPinIsOpen(uint8_T pin)
+    {
+        return (pin <= IO_PWM_MODULES_MAX) ? pwmPinOpen[pin] : 0;
+    }
+    
     /* PWM Initialisation selected by the pinNumber (PWM Channel) */
     MW_Handle_Type MW_PWM_Open(uint32_T pin, real_T frequency, real_T dutyCycle)
     {
@@ -68,8 +100,13 @@ extern "C" {
         {
             #if !defined(ESP_H)
             #if defined(ARDUINO_ARCH_RENESAS_UNO)
-            createPwmObject(pin);
-            pwmObjects[pwmPinCounter-1]->begin(frequency, 0, false, TIMER_SOURCE_DIV_1);
+            /* Without a frequency, or without a free timer channel, the pin
+             * is left to analogWrite at the default frequency */
+            if((frequency <= 0) || (createPwmObject((uint8_T)pin, frequency) == NULL))
+            {
+                releasePwmObject((uint8_T)pin);
+                pinMode((uint8_T)pin,OUTPUT);
+            }
             #elif defined(__IMXRT1062__)
             #include "core_pins.h"
             if(frequency > 0)                    // Specify Frequency
@@ -78,9 +115,39 @@ extern "C" {
             }
             #else
             pinMode((uint8_T)pin,OUTPUT);
+            /* A frequency runs the pin from its hardware timer where there is
+             * one free, otherwise analogWrite keeps the default frequency. A
+             * timer another pin already runs at its own frequency can take
+             * neither, so the open fails */
+            if(frequency > 0)
+            {
+                if(!timerPwmOpen((uint8_T)pin, frequency) && timerPwmTimerClaimed((uint8_T)pin))
+                {
+                    return (MW_Handle_Type)NULL;
+                }
+            }
+            else
+            {
+                /* Without a frequency the pin follows a timer already running timer PWM */
+                timerPwmJoin((uint8_T)pin);
+            }
             #endif
             #else /*ESP32*/
-                assignPWMChannel((uint8_T)pin);
+            /* Each pin runs at its own frequency, with the widest duty cycle it allows */
+            uint32_T pwmFrequency = (frequency > 0) ? (uint32_T)frequency : PWM_DEFAULT_FREQUENCY;
+            uint8_T resolution = getPWMResolution(pwmFrequency);
+            uint8_T channel = assignPWMChannel((uint8_T)pin, pwmFrequency, resolution);
+            if(channel == PWM_NO_CHANNEL)
+            {
+                return (MW_Handle_Type)NULL;
+            }
+            /* ledcSetup returns 0 when the timer cannot divide its clock down to the frequency */
+            if(ledcSetup(channel, pwmFrequency, resolution) == 0)
+            {
+                releasePWMChannel((uint8_T)pin);
+                return (MW_Handle_Type)NULL;
+            }
+            ledcAttachPin((uint8_T)pin, channel);
             #endif
 #if DEBUG_FLAG == 2
             DebugMsg.debugMsgID = DEBUGPWMOPEN;
@@ -89,6 +156,7 @@ extern "C" {
             DebugMsg.argNum = index;
             sendDebugPackets();
 #endif
+            pwmPinOpen[pin] = 1;
             return (MW_Handle_Type)(pin + 1);
         }
         else
@@ -103,6 +171,46 @@ extern "C" {
     {
     }
     
+    /* Drive a pin at a duty cycle in percent, without journaling it */
+    void writePwmDuty(uint8_T pin, real_T dutyCycle)
+    {
+        uint8_T dutyCycleValue = (uint8_T)(255*dutyCycle/100);
+        #if defined(ARDUINO_ARCH_RENESAS_UNO)
+            PwmOut* pwm = getPwmObject(pin);
+            if(pwm != NULL)
+            {
+                pwm->pulse_perc((float)dutyCycle);
+            }
+            else
+            {
+                analogWrite(pin, dutyCycleValue);  /* Default frequency*/
+            }
+        #elif !defined(ESP_H)
+            /* A pin whose timer was taken over for timer PWM after the pin
+             * was opened joins it, analogWrite would assume the default TOP */
+            if(!timerPwmWrite(pin, dutyCycle))
+            {
+                if(timerPwmJoin(pin))
+                {
+                    timerPwmWrite(pin, dutyCycle);
+                }
+                else
+                {
+                    analogWrite(pin, dutyCycleValue);
+                }
+            }
+        #else /*ESP32 */
+            uint8_T channel = getPWMChannel(pin);
+            if(channel != PWM_NO_CHANNEL)
+            {
+                /* Full resolution of the channel, the core turns the top value into fully on */
+                uint32_T maxDuty = (1UL << getPWMChannelResolution(channel)) - 1;
+                real_T duty = (dutyCycle < 0) ? 0 : ((dutyCycle > 100) ? 100 : dutyCycle);
+                ledcWrite(channel, (uint32_T)(maxDuty*duty/100 + 0.5));
+            }
+        #endif
+    }
+    
     /* Set the duty cycle or pulse width for the PWM signal */
     void MW_PWM_SetDutyCycle(MW_Handle_Type PWMPinHandle, real_T dutyCycle)
     {
@@ -113,31 +221,8 @@ extern "C" {
         uint8_T index=0;
 #endif
         dutyCycleValue = (uint8_T)(255*dutyCycle/100);
-        #if !defined(ESP_H)
-            analogWrite(pin, dutyCycleValue);
-        #elif defined(ARDUINO_ARCH_RENESAS_UNO)
-        uint8_T pin;
-        if(*((uint8_T*)(&PWMPinHandle)))
-        {
-            /* The handle of a Pin is stored as (Pin+1) */
-            pin =  *((uint8_T*)(&PWMPinHandle)) - 1;
-            if(PinMapTable[pin]==1)       /* Specify frequency */
-            {
-                dutyCycle = dutyCycle * -1;
-                int locPinIndex = getIndexForPWMPin(pin);
-                pwmObjects[locPinIndex]->pulse_perc((float)(dutyCycle * 100) / 255);
-            }
-            else
-            {
-                analogWrite(pin, dutyCycle);  /* Default frequency*/
-            }
-        }
-        #else /*ESP32 */
-            uint8_T channel = getPWMChannel(pin);
-            ledcAttachPin(pin, channel);
-            ledcSetup(channel, PWMFrequency, PWMResolution);
-            ledcWrite(channel, dutyCycleValue);
-        #endif
+        journalEvent(JOURNAL_PWM_WRITE, pin, dutyCycleValue);
+        writePwmDuty(pin, dutyCycle);
 #if DEBUG_FLAG == 2
         #if !defined(ESP_H)
             DebugMsg.debugMsgID = DEBUGPWMSETDUTYCYCLE;
@@ -148,7 +233,7 @@ extern "C" {
         #else        
             DebugMsg.debugMsgID = DEBUGPWMSETDUTYCYCLEESP32;
             DebugMsg.args[index++]=pin;
-            DebugMsg.args[index++]=channel;
+            DebugMsg.args[index++]=getPWMChannel(pin);
             DebugMsg.args[index++]=dutyCycleValue;
             DebugMsg.argNum = index;
             sendDebugPackets();
@@ -159,6 +244,8 @@ extern "C" {
     /* Set the PWM signal frequency */
     void MW_PWM_SetFrequency(MW_Handle_Type PWMPinHandle, real_T frequency)
     {
+        /* Only pins running from a hardware timer can change frequency */
+        timerPwmSetFrequency(*((uint8_T*)(&PWMPinHandle)) - 1, frequency);
     }
     
     /* Disable notifications on the channel */
@@ -192,6 +279,25 @@ extern "C" {
     /* Close PWM */
     void MW_PWM_Close(MW_Handle_Type PWMPinHandle)
     {
+        uint8_T pin = *((uint8_T*)(&PWMPinHandle)) - 1;
+        /* A waveform left running would drive the pin again on its next update */
+        releasePwmWaveform(pin);
+        if(pin <= IO_PWM_MODULES_MAX)
+        {
+            pwmPinOpen[pin] = 0;
+        }
+#if defined(ESP_H)
+        /* Give the channel back so that the pin can be opened again */
+        if(getPWMChannel(pin) != PWM_NO_CHANNEL)
+        {
+            ledcDetachPin(pin);
+            releasePWMChannel(pin);
+        }
+#elif defined(ARDUINO_ARCH_RENESAS_UNO)
+        releasePwmObject(pin);
+#else
+        timerPwmClose(pin);
+#endif
     }
     
 #ifdef __cplusplus
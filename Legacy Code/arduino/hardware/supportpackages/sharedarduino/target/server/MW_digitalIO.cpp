@@ -6,11 +6,31 @@
 #endif
 #include "MW_digitalIO.h"
 #include "IO_peripheralInclude.h"
+#include "eventJournalArduino.h"
+#include "digitalPortArduino.h"
+#include "debounceArduino.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
     
+#if DIGITAL_PORT_DIRECT
+    /* Registers of each opened pin, looked up once in MW_digitalIO_open so that
+     * reads and writes are a single masked load or store. Handles stay pin+1,
+     * pins that were not opened have no registers and use the Arduino core. */
+    typedef struct
+    {
+        volatile portWord_T* in;
+        volatile portWord_T* out;
+        portWord_T mask;
+        uint8_T direction;
+    } digitalIOPin_T;
+    static digitalIOPin_T digitalIOPins[IO_DIGITALIO_MODULES_MAX + 1];
+#else
+    /* Direction + 1 of each opened pin, 0 for pins that are not open */
+    static uint8_T digitalIODirections[IO_DIGITALIO_MODULES_MAX + 1];
+#endif
+    
     /* Called for each GPIO pin */
     MW_Handle_Type MW_digitalIO_open(uint32_T pin, uint8_T direction)
     {
@@ -31,6 +51,17 @@ extern "C" {
             {
                 pinMode(pin, INPUT_PULLUP);
             }
+#if DIGITAL_PORT_DIRECT
+            /* On AVR digitalRead also releases a PWM timer still driving the
+             * pin, which the direct writes would not do */
+            digitalRead(pin);
+            digitalIOPins[pin].in = pinInputRegister(pin);
+            digitalIOPins[pin].out = pinOutputRegister(pin);
+            digitalIOPins[pin].mask = pinBitMask(pin);
+            digitalIOPins[pin].direction = direction;
+#else
+            digitalIODirections[pin] = direction + 1;
+#endif
 #if DEBUG_FLAG == 2
             DebugMsg.debugMsgID= DEBUGOPENDIGITALPIN;
             DebugMsg.args[index++]=(uint8_T)pin;
@@ -53,7 +84,15 @@ extern "C" {
         uint8_T index=0;
 #endif
         pin = *((uint8_T*)(&DigitalIOPinHandle)) - 1;
+#if DIGITAL_PORT_DIRECT
+        if ((pin <= IO_DIGITALIO_MODULES_MAX) && (digitalIOPins[pin].in != NULL))
+        {
+            ret = ((*digitalIOPins[pin].in) & digitalIOPins[pin].mask) ? 1:0;
+        }
+        else
+#endif
         ret = (digitalRead((uint8_T)pin) == HIGH) ? 1:0;
+        ret = debouncedLevel(pin, ret);
 #if DEBUG_FLAG == 2
         DebugMsg.debugMsgID= DEBUGREADDIGITALPIN;
         DebugMsg.args[index++]=pin;
@@ -72,6 +111,16 @@ extern "C" {
         uint8_T index=0;
 #endif
         pin = *((uint8_T*)(&DigitalIOPinHandle)) - 1;
+#if DIGITAL_PORT_DIRECT
+        /* Pins opened as inputs keep the core's handling of writes, which
+         * switches the pull-up on some boards */
+        if ((pin <= IO_DIGITALIO_MODULES_MAX) && (digitalIOPins[pin].out != NULL) && (digitalIOPins[pin].direction == (uint8_T)1))
+        {
+            portWord_T mask = digitalIOPins[pin].mask;
+            writePortBits(digitalIOPins[pin].out, value ? mask : 0, value ? 0 : mask);
+        }
+        else
+#endif
         if (value)
         {
             digitalWrite((uint8_T)pin, HIGH);
@@ -80,6 +129,7 @@ extern "C" {
         {
             digitalWrite((uint8_T)pin, LOW);
         }
+        journalEvent(JOURNAL_DIGITAL_WRITE, pin, (uint16_T)(value ? 1 : 0));
 #if DEBUG_FLAG == 2
         DebugMsg.debugMsgID= DEBUGWRITEDIGITALPIN;
         DebugMsg.args[index++]=pin;
@@ -99,6 +149,18 @@ extern "C" {
         pin = *((uint8_T*)(&DigitalIOPinHandle)) - 1;
         /* set the pin to default state */
         pinMode(pin, INPUT);
+#if DIGITAL_PORT_DIRECT
+        if (pin <= IO_DIGITALIO_MODULES_MAX)
+        {
+            digitalIOPins[pin].in = NULL;
+            digitalIOPins[pin].out = NULL;
+        }
+#else
+        if (pin <= IO_DIGITALIO_MODULES_MAX)
+        {
+            digitalIODirections[pin] = 0;
+        }
+#endif
 #if DEBUG_FLAG == 2
         DebugMsg.debugMsgID= DEBUGUNCONFIGUREDIGITALPIN;
         DebugMsg.args[index++]=pin;
@@ -109,6 +171,19 @@ extern "C" {
 #endif
     }
     
+    uint8_T digitalPinOpenAsOutput(uint8_T pin)
+    {
+        if (pin > IO_DIGITALIO_MODULES_MAX)
+        {
+            return 0;
+        }
+#if DIGITAL_PORT_DIRECT
+        return ((digitalIOPins[pin].out != NULL) && (digitalIOPins[pin].direction == (uint8_T)1)) ? 1 : 0;
+#else
+        return (digitalIODirections[pin] == (uint8_T)2) ? 1 : 0;
+#endif
+    }
+    
 #ifdef __cplusplus
 }
 #endif
@@ -3,42 +3,154 @@
  *
  * Provides channel assignement for PWM and Servo on ESP32 hardware.
  *
+ * The LEDC channels come in pairs that share a timer, so both channels of a
+ * pair run at the same frequency and resolution. Pairs with no channel in use
+ * are kept in a free mask; a pin takes the other channel of a pair already
+ * running at its frequency before it takes a free pair. Channels are returned
+ * when the PWM pin or the servo is closed.
+ *
  * @copyright Copyright 2018-2022 The MathWorks, Inc.
  *
  */
 
-#include "IO_include.h"
-#include "MW_PWM.h"
-#include "IO_peripheralInclude.h"
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "PWMChannel.h"
 
 #if defined (ESP_H)
-  static uint16_T PWMFrequency = 1000; // this variable is used to define the time period
-  static uint8_T PWMResolution = 8; // this will define the resolution of the signal which is 8 in this case
-  static uint8_T PinChannelMap[IO_PWM_MODULES_MAX]; //ADD correct PWM ARRAY SIZE BASED On size of MAP
-  static bool PWMChannels[16] = {0};
-  static const uint8_T numChannels = 16;
 
+/* As the core counts them, low speed and high speed channels together */
+#if defined(SOC_LEDC_CHANNEL_NUM) && defined(SOC_LEDC_SUPPORT_HS_MODE)
+#define PWM_NUM_CHANNELS (SOC_LEDC_CHANNEL_NUM * 2)
+#elif defined(SOC_LEDC_CHANNEL_NUM)
+#define PWM_NUM_CHANNELS SOC_LEDC_CHANNEL_NUM
+#else
+#define PWM_NUM_CHANNELS 16
+#endif
+#define PWM_NUM_TIMERS (PWM_NUM_CHANNELS / 2)
+
+#if defined(SOC_LEDC_TIMER_BIT_WIDE_NUM)
+#define PWM_MAX_RESOLUTION SOC_LEDC_TIMER_BIT_WIDE_NUM
+#else
+#define PWM_MAX_RESOLUTION 20
+#endif
+
+/* LEDC timers count from the 80 MHz APB clock */
+#define PWM_TIMER_CLOCK 80000000UL
 
-static void assignPWMChannel(uint8_T pin)
-{
-    for(int i = 0; i < numChannels; ++i)
+/* Pins the channel map covers, PWM pins and servo pins alike */
+#if IO_DIGITALIO_MODULES_MAX > IO_PWM_MODULES_MAX
+#define PWM_CHANNEL_PINS (IO_DIGITALIO_MODULES_MAX + 1)
+#else
+#define PWM_CHANNEL_PINS (IO_PWM_MODULES_MAX + 1)
+#endif
+
+extern "C" {
+    
+    struct pwmTimer_t
+    {
+        uint32_T frequency;
+        uint8_T resolution;
+        uint8_T channels;       /* Bit 0 and bit 1 for the two channels of the pair */
+    };
+    static struct pwmTimer_t pwmTimers[PWM_NUM_TIMERS];
+    
+    /* Bit per timer with neither channel in use */
+    static uint32_T freeTimers = (1UL << PWM_NUM_TIMERS) - 1;
+    
+    /* Channel + 1 of each pin, 0 for none */
+    static uint8_T pinChannelMap[PWM_CHANNEL_PINS];
+    
+    uint8_T getPWMResolution(uint32_T frequency)
     {
-        if(PWMChannels[i] == 0)
+        uint8_T bits = 1;
+        
+        while ((bits < PWM_MAX_RESOLUTION) && ((uint64_t)frequency << (bits + 1)) <= PWM_TIMER_CLOCK)
         {
-            PinChannelMap[pin] = i;
-            PWMChannels[i] = 1;
-            break;
+            bits++;
         }
-
-        /* No channel is available */
-        //Add error or debug print if possible
+        return bits;
+    }
+    
+    uint8_T getPWMChannel(uint8_T pin)
+    {
+        if ((pin >= PWM_CHANNEL_PINS) || (pinChannelMap[pin] == 0))
+        {
+            return PWM_NO_CHANNEL;
+        }
+        return (uint8_T)(pinChannelMap[pin] - 1);
+    }
+    
+    uint8_T getPWMChannelResolution(uint8_T channel)
+    {
+        return pwmTimers[channel / 2].resolution;
+    }
+    
+    void releasePWMChannel(uint8_T pin)
+    {
+        uint8_T channel = getPWMChannel(pin);
+        uint8_T timer;
+        
+        if (channel == PWM_NO_CHANNEL)
+        {
+            return;
+        }
+        timer = channel / 2;
+        pwmTimers[timer].channels &= (uint8_T)~(1U << (channel % 2));
+        if (pwmTimers[timer].channels == 0)
+        {
+            freeTimers |= (1UL << timer);
+        }
+        pinChannelMap[pin] = 0;
+    }
+    
+    uint8_T assignPWMChannel(uint8_T pin, uint32_T frequency, uint8_T resolution)
+    {
+        uint8_T channel, timer;
+        
+        if (pin >= PWM_CHANNEL_PINS)
+        {
+            return PWM_NO_CHANNEL;
+        }
+        channel = getPWMChannel(pin);
+        if (channel != PWM_NO_CHANNEL)
+        {
+            timer = channel / 2;
+            if ((pwmTimers[timer].frequency == frequency) && (pwmTimers[timer].resolution == resolution))
+            {
+                return channel;
+            }
+            releasePWMChannel(pin);
+        }
+        
+        /* Share a timer already at this frequency before taking a free one */
+        for (timer = 0; timer < PWM_NUM_TIMERS; timer++)
+        {
+            if ((pwmTimers[timer].channels == 0x01 || pwmTimers[timer].channels == 0x02) &&
+                    (pwmTimers[timer].frequency == frequency) && (pwmTimers[timer].resolution == resolution))
+            {
+                break;
+            }
+        }
+        if (timer == PWM_NUM_TIMERS)
+        {
+            if (freeTimers == 0)
+            {
+                return PWM_NO_CHANNEL;
+            }
+            timer = (uint8_T)__builtin_ctz(freeTimers);
+            freeTimers &= ~(1UL << timer);
+            pwmTimers[timer].frequency = frequency;
+            pwmTimers[timer].resolution = resolution;
+        }
+        channel = (uint8_T)(2*timer + ((pwmTimers[timer].channels & 0x01) ? 1 : 0));
+        pwmTimers[timer].channels |= (uint8_T)(1U << (channel % 2));
+        pinChannelMap[pin] = (uint8_T)(channel + 1);
+        return channel;
     }
 }
 
-static uint8_T getPWMChannel(uint8_T pin)
-{
-    uint8_T channel = PinChannelMap[pin];
-    return channel;
-}
-
-#endif
\ No newline at end of file
+#endif
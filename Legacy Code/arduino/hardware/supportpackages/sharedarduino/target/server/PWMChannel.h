@@ -0,0 +1,50 @@
+/**
+ * @file PWMChannel.h
+ *
+ * Provides headers to PWMChannel.cpp
+ *
+ */
+
+#ifndef PWMCHANNEL_H
+#define PWMCHANNEL_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined (ESP_H)
+
+/* Returned when a pin holds no channel or none can be assigned */
+#define PWM_NO_CHANNEL 0xFF
+
+/* Frequency used when MW_PWM_Open is not given one */
+#define PWM_DEFAULT_FREQUENCY 1000
+
+/* Timer the Servo library sets up on the channel it is given */
+#define SERVO_LEDC_FREQUENCY    50
+#define SERVO_LEDC_RESOLUTION   16
+
+/* Widest duty cycle in bits a frequency in Hz can have */
+uint8_T getPWMResolution(uint32_T frequency);
+/* Assign a LEDC channel to a pin. Channels that share a LEDC timer are only
+ * given to pins at the same frequency and resolution. A pin already holding a
+ * channel at that frequency keeps it. Returns PWM_NO_CHANNEL when no channel is
+ * free on a timer that suits */
+uint8_T assignPWMChannel(uint8_T pin, uint32_T frequency, uint8_T resolution);
+/* Channel held by a pin, or PWM_NO_CHANNEL */
+uint8_T getPWMChannel(uint8_T pin);
+/* Duty cycle resolution in bits the timer of a channel runs at */
+uint8_T getPWMChannelResolution(uint8_T channel);
+/* Return the channel of a pin to the pool */
+void releasePWMChannel(uint8_T pin);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
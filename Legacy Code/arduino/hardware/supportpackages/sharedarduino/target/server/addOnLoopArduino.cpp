@@ -0,0 +1,137 @@
+/**
+ * @file addOnLoopArduino.cpp
+ *
+ * Cooperative, time-budgeted execution of the loop() of the add-on libraries.
+ *
+ * Every pass starts with the library after the one that started the previous pass.
+ * A library whose loop() runs over its budget accumulates the excess as debt and
+ * is skipped on later passes until the debt is paid off, one budget per skipped
+ * pass. A pass ends early once the pass budget is used up, and the next pass
+ * resumes with the first library that did not get to run.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "addOnLoopArduino.h"
+
+#if ADD_ON
+#include "hardware.h"
+#include "MWArduinoClass.h"
+
+/* Libraries beyond this count still run but are not budgeted */
+#define MAX_BUDGETED_LIBRARIES 16
+
+extern "C" {
+    
+    extern MWArduinoClass hwObject;
+    
+    struct addOnLoopStats_t
+    {
+        uint32_T totalUs;
+        uint32_T maxUs;
+        uint32_T calls;
+        uint32_T skipped;
+        uint32_T debtUs;
+    };
+    static addOnLoopStats_t addOnLoopStats[MAX_BUDGETED_LIBRARIES];
+    
+    /* 0 disables the respective budget */
+    static uint32_T libraryBudgetUs = 1000;
+    static uint32_T passBudgetUs = 2000;
+    static uint8_T nextLibrary = 0;
+    
+    void runAddOnLoops(void)
+    {
+        int numLibraries = hwObject.noOfLibraries;
+        unsigned long passStart, startTime, elapsed;
+        uint8_T first, count, current;
+        
+        if(numLibraries <= 0)
+        {
+            return;
+        }
+        if(nextLibrary >= numLibraries)
+        {
+            nextLibrary = 0;
+        }
+        first = nextLibrary;
+        current = first;
+        passStart = micros();
+        for(count = 0; count < numLibraries; count++)
+        {
+            current = (uint8_T)((first + count) % numLibraries);
+            if((count > 0) && (passBudgetUs != 0) && ((micros() - passStart) >= passBudgetUs))
+            {
+                break;
+            }
+            if(current >= MAX_BUDGETED_LIBRARIES)
+            {
+                hwObject.arrayOfLibraries[current]->loop();
+                continue;
+            }
+            addOnLoopStats_t& stats = addOnLoopStats[current];
+            if((libraryBudgetUs != 0) && (stats.debtUs >= libraryBudgetUs))
+            {
+                stats.debtUs -= libraryBudgetUs;
+                stats.skipped++;
+                continue;
+            }
+            startTime = micros();
+            hwObject.arrayOfLibraries[current]->loop();
+            elapsed = micros() - startTime;
+            
+            stats.totalUs += elapsed;
+            stats.calls++;
+            if(elapsed > stats.maxUs)
+            {
+                stats.maxUs = elapsed;
+            }
+            if((libraryBudgetUs != 0) && (elapsed > libraryBudgetUs))
+            {
+                stats.debtUs += elapsed - libraryBudgetUs;
+            }
+        }
+        /* Resume with the first library left out of a truncated pass, otherwise rotate by one */
+        nextLibrary = (count < numLibraries) ? current : (uint8_T)((first + 1) % numLibraries);
+    }
+    
+    /* Payload: library index (uint8). Responds with the number of libraries (uint8)
+     * followed by total time, maximum time, calls and skipped passes, all uint32 */
+    void readAddOnLoopStats(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T ID, numLibraries = (uint8_T)hwObject.noOfLibraries;
+        uint32_T result[4] = {0, 0, 0, 0};
+        
+        memcpy(&ID, &payloadBufferRx[0], sizeof(uint8_T));
+        if((ID < numLibraries) && (ID < MAX_BUDGETED_LIBRARIES))
+        {
+            result[0] = addOnLoopStats[ID].totalUs;
+            result[1] = addOnLoopStats[ID].maxUs;
+            result[2] = addOnLoopStats[ID].calls;
+            result[3] = addOnLoopStats[ID].skipped;
+        }
+        payloadBufferTx[(*peripheralDataSizeResponse)] = numLibraries;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], result, sizeof(result));
+        (*peripheralDataSizeResponse) += sizeof(result);
+    }
+    
+    /* Payload: library budget and pass budget in microseconds (uint32 each). Clears the statistics. */
+    void setAddOnLoopBudget(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0;
+        
+        memcpy(&libraryBudgetUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&passBudgetUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memset(addOnLoopStats, 0, sizeof(addOnLoopStats));
+    }
+}
+#endif //ADD_ON
@@ -0,0 +1,31 @@
+/**
+ * @file addOnLoopArduino.h
+ *
+ * Provides headers to addOnLoopArduino.cpp
+ *
+ */
+
+#ifndef ADDONLOOPARDUINO_H
+#define ADDONLOOPARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ADD_ON
+/* Run the loop() of the add-on libraries within the configured time budget */
+void runAddOnLoops(void);
+/* Read the time used by the loop() of one add-on library */
+void readAddOnLoopStats(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Set the per library and per pass time budget of the add-on loop() calls */
+void setAddOnLoopBudget(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
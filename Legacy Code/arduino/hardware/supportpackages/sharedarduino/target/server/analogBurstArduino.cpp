@@ -0,0 +1,187 @@
+/**
+ * @file analogBurstArduino.cpp
+ *
+ * Burst reads of analog pins. A list of pins is read a number of times at a
+ * fixed spacing and all the samples come back in one response, encoded to
+ * fit as many as possible. Each scan is timed from the start of the burst,
+ * so a late scan does not delay the ones after it. The server is busy for
+ * the whole burst; for longer captures use the continuous analog scan.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "analogBurstArduino.h"
+#include "analogConfigArduino.h"
+#include "pulseTrainArduino.h"
+#include "customFunction.h"
+    
+/* Status (uint8), scans taken (uint16), time of the first scan (uint32) and late scans (uint16) */
+#define ANALOG_BURST_HEADER_SIZE 9
+    
+    /* Bytes taken by a number of samples packed in 12 bits */
+    static uint32_T packedSize(uint32_T samples)
+    {
+        return (samples / 2)*3 + (samples & 1)*2;
+    }
+    
+    /* Sample k of the burst in PACKED12. An even sample takes a byte and the
+     * low nibble of the next, an odd one the high nibble and another byte */
+    static uint16_T packSample(uint8_T* dst, uint16_T size, uint32_T k, uint16_T value)
+    {
+        if ((k & 1) == 0)
+        {
+            dst[size++] = (uint8_T)(value & 0xFF);
+            dst[size++] = (uint8_T)((value >> 8) & 0x0F);
+        }
+        else
+        {
+            dst[size - 1] |= (uint8_T)((value & 0x0F) << 4);
+            dst[size++] = (uint8_T)(value >> 4);
+        }
+        return size;
+    }
+    
+    /* A sample in DELTA8 as the difference from the previous sample of the
+     * same pin, or the full sample after ANALOG_BURST_DELTA_ESCAPE */
+    static uint16_T deltaSample(uint8_T* dst, uint16_T size, uint8_T first, uint16_T value, uint16_T* previous)
+    {
+        int32_T delta = (int32_T)value - (int32_T)(*previous);
+        
+        *previous = value;
+        if (!first && (delta >= -127) && (delta <= 127))
+        {
+            dst[size++] = (uint8_T)(int8_T)delta;
+            return size;
+        }
+        if (!first)
+        {
+            dst[size++] = ANALOG_BURST_DELTA_ESCAPE;
+        }
+        memcpy(&dst[size], &value, sizeof(uint16_T));
+        return (uint16_T)(size + sizeof(uint16_T));
+    }
+    
+    /* Payload: interval between scans in us (uint32), scans (uint16),
+     * encoding (uint8), one of ANALOG_BURST_PACKED12 or ANALOG_BURST_DELTA8,
+     * pin count (uint8) and the pins. Responds with an ANALOG_BURST_ status,
+     * the scans taken (uint16), the time of the first scan (uint32), the
+     * scans taken more than one interval late (uint16), then the samples in
+     * scan order. A DELTA8 burst stops early at the first scan that does not
+     * fit in the response */
+    void readAnalogBurst(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, scans, taken = 0, lateScans = 0;
+        uint8_T encoding, count, status = ANALOG_BURST_OK;
+        uint8_T* pins;
+        uint32_T intervalUs, startUs = 0, dueUs;
+        uint16_T values[ANALOG_BURST_MAX_CHANNELS];
+        uint16_T previous[ANALOG_BURST_MAX_CHANNELS];
+        uint8_T* dst = &payloadBufferTx[(*peripheralDataSizeResponse)];
+        uint16_T room = (uint16_T)(CUSTOM_FUNCTION_RESPONSE_SIZE - (*peripheralDataSizeResponse) - ANALOG_BURST_HEADER_SIZE);
+        uint16_T size = ANALOG_BURST_HEADER_SIZE;
+        uint32_T k = 0;
+        
+        memcpy(&intervalUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&scans, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&encoding, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&count, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        pins = &payloadBufferRx[index];
+        
+        if ((count == 0) || (count > ANALOG_BURST_MAX_CHANNELS) || (scans == 0))
+        {
+            status = ANALOG_BURST_BAD_COUNT;
+        }
+        else if (encoding > ANALOG_BURST_DELTA8)
+        {
+            status = ANALOG_BURST_BAD_ENCODING;
+        }
+        else if (((encoding == ANALOG_BURST_PACKED12) && (packedSize((uint32_T)scans*count) > room)) ||
+                ((encoding == ANALOG_BURST_DELTA8) && ((uint32_T)(scans + 1)*count > room)))
+        {
+            status = ANALOG_BURST_BAD_SIZE;
+        }
+        else if (intervalUs > ANALOG_BURST_MAX_US/scans)
+        {
+            status = ANALOG_BURST_BAD_DURATION;
+        }
+        for (uint8_T c = 0; (status == ANALOG_BURST_OK) && (c < count); c++)
+        {
+            if (pins[c] > IO_ANALOGINPUT_MODULES_MAX)
+            {
+                status = ANALOG_BURST_BAD_PIN;
+            }
+        }
+        
+        if (status == ANALOG_BURST_OK)
+        {
+            applyAnalogConfig();
+            startUs = micros();
+            for (taken = 0; taken < scans; taken++)
+            {
+                dueUs = startUs + taken*intervalUs;
+                /* Pulse trains keep running between scans */
+                while ((long)(micros() - dueUs) < 0)
+                {
+                    runPulseTrains();
+                }
+                if ((intervalUs > 0) && ((uint32_T)(micros() - dueUs) >= intervalUs))
+                {
+                    lateScans++;
+                }
+                for (uint8_T c = 0; c < count; c++)
+                {
+                    values[c] = (uint16_T)analogRead(pins[c]);
+                }
+                if ((encoding == ANALOG_BURST_DELTA8) && (taken > 0))
+                {
+                    /* A scan that does not fit in full ends the burst */
+                    uint16_T scanSize = 0;
+                    for (uint8_T c = 0; c < count; c++)
+                    {
+                        int32_T delta = (int32_T)values[c] - (int32_T)previous[c];
+                        scanSize += ((delta >= -127) && (delta <= 127)) ? 1 : 3;
+                    }
+                    if ((uint16_T)(size - ANALOG_BURST_HEADER_SIZE + scanSize) > room)
+                    {
+                        break;
+                    }
+                }
+                for (uint8_T c = 0; c < count; c++, k++)
+                {
+                    if (encoding == ANALOG_BURST_PACKED12)
+                    {
+                        size = packSample(dst, size, k, values[c]);
+                    }
+                    else
+                    {
+                        size = deltaSample(dst, size, (taken == 0), values[c], &previous[c]);
+                    }
+                }
+            }
+        }
+        
+        dst[0] = status;
+        memcpy(&dst[1], &taken, sizeof(uint16_T));
+        memcpy(&dst[3], &startUs, sizeof(uint32_T));
+        memcpy(&dst[7], &lateScans, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += size;
+    }
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+/**
+ * @file analogBurstArduino.h
+ *
+ * Helper for analogBurstArduino.cpp
+ *
+ */
+
+#ifndef ANALOGBURSTARDUINO_H
+#define ANALOGBURSTARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Analog pins read in each scan of a burst */
+#define ANALOG_BURST_MAX_CHANNELS 8
+
+/* Longest the server may be held by one burst */
+#ifndef ANALOG_BURST_MAX_US
+#define ANALOG_BURST_MAX_US 1000000UL
+#endif
+
+/* Sample encodings */
+#define ANALOG_BURST_PACKED12   0   /* Two samples in three bytes, low bits first */
+#define ANALOG_BURST_DELTA8     1   /* First scan as uint16, then int8 differences per pin */
+
+/* Marks a DELTA8 sample whose difference does not fit, the uint16 sample follows */
+#define ANALOG_BURST_DELTA_ESCAPE 0x80
+
+/* Status returned ahead of the samples */
+#define ANALOG_BURST_OK             0
+#define ANALOG_BURST_BAD_COUNT      1
+#define ANALOG_BURST_BAD_PIN        2
+#define ANALOG_BURST_BAD_ENCODING   3
+#define ANALOG_BURST_BAD_SIZE       4
+#define ANALOG_BURST_BAD_DURATION   5
+
+/* Read a list of analog pins a number of times at a fixed spacing and return all the samples at once */
+void readAnalogBurst(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file analogConfigArduino.h
+ *
+ * ADC settings shared by MW_AnalogInput.cpp and the analog custom functions
+ *
+ */
+
+#ifndef ANALOGCONFIGARDUINO_H
+#define ANALOGCONFIGARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Resolution analogRead() returns once the configuration is applied. ESP32
+ * reads 12 bits by default, it is set all the same so that the custom
+ * functions scale by the width the ADC really returns */
+#if defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040) || defined(ARDUINO_ARCH_RENESAS_UNO) || \
+    defined(ARDUINO_ARCH_ESP32) || defined(ESP_H)
+#define ANALOG_READ_BITS 12
+#else
+#define ANALOG_READ_BITS 10
+#endif
+
+/* Set the resolution and the reference of the ADC, only the first call after a change does any work */
+void applyAnalogConfig(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file analogOversampleArduino.cpp
+ *
+ * Oversampled analog reads. Each extra bit of resolution takes four times
+ * the conversions, which the board averages so that one value goes to the
+ * host instead of every conversion. The noise on the input has to be at
+ * least one count for the extra bits to carry information.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "analogOversampleArduino.h"
+#include "analogConfigArduino.h"
+    
+    /* Payload: pin (uint8), extra bits (uint8), filter (uint8), one of
+     * OVERSAMPLE_BOXCAR or OVERSAMPLE_CIC2. Responds with an OVERSAMPLE_
+     * status, the resolution of the value in bits (uint8) and the value (uint16) */
+    void readAnalogOversampled(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, value = 0;
+        uint8_T pin, bits, mode, status = OVERSAMPLE_OK;
+        uint32_T sum = 0, decimation, shift;
+        
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&bits, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&mode, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        if (pin > IO_ANALOGINPUT_MODULES_MAX)
+        {
+            status = OVERSAMPLE_BAD_PIN;
+        }
+        else if (bits > OVERSAMPLE_MAX_EXTRA_BITS)
+        {
+            status = OVERSAMPLE_BAD_BITS;
+        }
+        else if (mode > OVERSAMPLE_CIC2)
+        {
+            status = OVERSAMPLE_BAD_MODE;
+        }
+        
+        if (status == OVERSAMPLE_OK)
+        {
+            applyAnalogConfig();
+            decimation = 1UL << (2*bits);
+            if (mode == OVERSAMPLE_BOXCAR)
+            {
+                for (uint32_T k = 0; k < decimation; k++)
+                {
+                    sum += (uint16_T)analogRead(pin);
+                }
+                /* Gain of 4^bits, keep bits of it */
+                shift = bits;
+            }
+            else
+            {
+                /* Two boxcars of length R in cascade weigh the 2R-1 conversions
+                 * 1, 2 .. R .. 2, 1, which rejects the aliases around multiples
+                 * of the output rate better than one boxcar */
+                for (uint32_T k = 0; k < 2*decimation - 1; k++)
+                {
+                    uint32_T weight = (k < decimation) ? (k + 1) : (2*decimation - 1 - k);
+                    sum += weight * (uint16_T)analogRead(pin);
+                }
+                /* Gain of R^2 = 16^bits, keep bits of it */
+                shift = 3UL*bits;
+            }
+            value = (uint16_T)((shift > 0) ? ((sum + (1UL << (shift - 1))) >> shift) : sum);
+            /* Rounding up from the top count would overflow the new resolution */
+            if (value >> (ANALOG_READ_BITS + bits))
+            {
+                value = (uint16_T)((1UL << (ANALOG_READ_BITS + bits)) - 1);
+            }
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        payloadBufferTx[(*peripheralDataSizeResponse)] = (uint8_T)(ANALOG_READ_BITS + bits);
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &value, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += sizeof(uint16_T);
+    }
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+/**
+ * @file analogOversampleArduino.h
+ *
+ * Helper for analogOversampleArduino.cpp
+ *
+ */
+
+#ifndef ANALOGOVERSAMPLEARDUINO_H
+#define ANALOGOVERSAMPLEARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Resolution that can be added to the ADC, 4 bits takes 256 conversions with boxcar */
+#define OVERSAMPLE_MAX_EXTRA_BITS 4
+
+/* Decimation filters */
+#define OVERSAMPLE_BOXCAR   0   /* Mean of 4^bits conversions */
+#define OVERSAMPLE_CIC2     1   /* Second order CIC, triangular weights over 2*4^bits-1 conversions */
+
+/* Status returned ahead of the value */
+#define OVERSAMPLE_OK       0
+#define OVERSAMPLE_BAD_PIN  1
+#define OVERSAMPLE_BAD_BITS 2
+#define OVERSAMPLE_BAD_MODE 3
+
+/* Read one analog pin with extra bits of resolution from oversampling */
+void readAnalogOversampled(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file analogScanArduino.cpp
+ *
+ * Continuous sampling of a list of analog pins. Every period loop() takes
+ * one scan, a reading of each pin in list order, into the block being
+ * filled. Two blocks are used in turn, so a completed block waits for the
+ * host while the next one fills. Scans are scheduled from the previous one
+ * rather than from when they were taken, so the rate does not drift. Blocks
+ * are either pushed in unsolicited frames or read with readAnalogBlock.
+ *
+ * The scans are taken from loop() rather than a timer interrupt, since an
+ * interrupt would land in the middle of the conversions of the other analog
+ * reads. So each block carries the longest any of its scans was taken after
+ * it was due, for the host to judge the timing, along with the scans missed
+ * altogether.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "analogScanArduino.h"
+#include "analogConfigArduino.h"
+#include "pushFrameArduino.h"
+#include "customFunction.h"
+
+/* Sequence (uint16), time of the first scan (uint32), scans (uint8),
+ * channels (uint8), blocks lost (uint16), late scans (uint16) and the
+ * largest lateness of a scan (uint16) */
+#define ANALOG_BLOCK_HEADER_SIZE 14
+
+extern "C" {
+    
+    struct analogBlock_t
+    {
+        uint16_T sequence;
+        uint32_T startUs;
+        uint8_T scans;
+        uint8_T ready;          /* Complete and not yet sent */
+        uint16_T maxLateUs;     /* Longest a scan of the block was taken after it was due */
+        uint16_T samples[ANALOG_SCAN_BLOCK_SAMPLES];
+    };
+    static struct analogBlock_t analogBlocks[2];
+    static uint8_T fillBlock = 0;
+    
+    static uint8_T scanPins[ANALOG_SCAN_MAX_CHANNELS];
+    static uint8_T numChannels = 0;
+    static uint8_T scansPerBlock = 0;
+    static uint8_T scanRunning = 0;
+    static uint8_T pushBlocks = 0;
+    static uint32_T scanPeriodUs = 0;
+    static unsigned long nextScanUs = 0;
+    static uint16_T nextSequence = 0;
+    static uint16_T blocksLost = 0;
+    static uint16_T lateScans = 0;
+    
+    /* Block header and samples, returns the number of bytes written */
+    static uint16_T writeAnalogBlock(struct analogBlock_t* block, uint8_T* dst)
+    {
+        uint16_T size = 0;
+        uint16_T sampleBytes = (uint16_T)(block->scans * numChannels * sizeof(uint16_T));
+        
+        memcpy(&dst[size], &block->sequence, sizeof(uint16_T));
+        size += sizeof(uint16_T);
+        memcpy(&dst[size], &block->startUs, sizeof(uint32_T));
+        size += sizeof(uint32_T);
+        dst[size++] = block->scans;
+        dst[size++] = numChannels;
+        memcpy(&dst[size], &blocksLost, sizeof(uint16_T));
+        size += sizeof(uint16_T);
+        memcpy(&dst[size], &lateScans, sizeof(uint16_T));
+        size += sizeof(uint16_T);
+        memcpy(&dst[size], &block->maxLateUs, sizeof(uint16_T));
+        size += sizeof(uint16_T);
+        memcpy(&dst[size], block->samples, sampleBytes);
+        size += sampleBytes;
+        
+        blocksLost = 0;
+        lateScans = 0;
+        block->ready = 0;
+        return size;
+    }
+    
+    static void sendAnalogBlock(struct analogBlock_t* block)
+    {
+        uint8_T frame[ANALOG_BLOCK_HEADER_SIZE + ANALOG_SCAN_BLOCK_SAMPLES*sizeof(uint16_T)];
+        sendPushFrame(ANALOG_BLOCK_FRAME_START, frame, writeAnalogBlock(block, frame));
+    }
+    
+    void runAnalogScan(void)
+    {
+        struct analogBlock_t* block;
+        unsigned long now, lateness;
+        uint16_T offset;
+        
+        if (!scanRunning)
+        {
+            return;
+        }
+        now = micros();
+        if ((long)(now - nextScanUs) < 0)
+        {
+            return;
+        }
+        lateness = now - nextScanUs;
+        
+        block = &analogBlocks[fillBlock];
+        if (block->scans == 0)
+        {
+            block->sequence = nextSequence++;
+            block->startUs = now;
+            block->maxLateUs = 0;
+        }
+        if (lateness > block->maxLateUs)
+        {
+            block->maxLateUs = (uint16_T)((lateness > 0xFFFF) ? 0xFFFF : lateness);
+        }
+        offset = (uint16_T)(block->scans * numChannels);
+        for (uint8_T c = 0; c < numChannels; c++)
+        {
+            block->samples[offset + c] = (uint16_T)analogRead(scanPins[c]);
+        }
+        block->scans++;
+        
+        /* Scans missed while loop() was busy are counted, not taken late */
+        if (lateness >= scanPeriodUs)
+        {
+            uint32_T missed = lateness / scanPeriodUs;
+            lateScans = (uint16_T)(((uint32_T)lateScans + missed > 0xFFFF) ? 0xFFFF : (lateScans + missed));
+            nextScanUs = now + scanPeriodUs;
+        }
+        else
+        {
+            nextScanUs += scanPeriodUs;
+        }
+        
+        if (block->scans >= scansPerBlock)
+        {
+            block->ready = 1;
+            fillBlock ^= 1;
+            /* The host has not taken the block before this one, it is overwritten */
+            if (analogBlocks[fillBlock].ready)
+            {
+                analogBlocks[fillBlock].ready = 0;
+                if (blocksLost < 0xFFFF)
+                {
+                    blocksLost++;
+                }
+            }
+            analogBlocks[fillBlock].scans = 0;
+            if (pushBlocks)
+            {
+                sendAnalogBlock(block);
+            }
+        }
+    }
+    
+    /* Payload: period in us (uint32), push (uint8), number of pins (uint8), pins (uint8 each).
+     * Responds with an ANALOG_SCAN_ status */
+    void startAnalogScan(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, fit;
+        uint32_T periodUs;
+        uint8_T push, count, status = ANALOG_SCAN_OK;
+        
+        memcpy(&periodUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&push, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&count, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        if ((count == 0) || (count > ANALOG_SCAN_MAX_CHANNELS))
+        {
+            status = ANALOG_SCAN_BAD_COUNT;
+        }
+        else if (periodUs == 0)
+        {
+            status = ANALOG_SCAN_BAD_PERIOD;
+        }
+        for (uint8_T c = 0; (status == ANALOG_SCAN_OK) && (c < count); c++)
+        {
+            if (payloadBufferRx[index + c] > IO_ANALOGINPUT_MODULES_MAX)
+            {
+                status = ANALOG_SCAN_BAD_PIN;
+            }
+        }
+        
+        if (status == ANALOG_SCAN_OK)
+        {
+            numChannels = count;
+            for (uint8_T c = 0; c < count; c++)
+            {
+                scanPins[c] = payloadBufferRx[index + c];
+                pinMode(scanPins[c], INPUT);
+            }
+            applyAnalogConfig();
+            /* Whole scans per block, and a block must fit in one response */
+            scansPerBlock = (uint8_T)(ANALOG_SCAN_BLOCK_SAMPLES / count);
+            fit = (uint16_T)((CUSTOM_FUNCTION_RESPONSE_SIZE - sizeof(uint8_T) - ANALOG_BLOCK_HEADER_SIZE) / (count * sizeof(uint16_T)));
+            if (fit < scansPerBlock)
+            {
+                scansPerBlock = (uint8_T)fit;
+            }
+            scanPeriodUs = periodUs;
+            pushBlocks = push;
+            fillBlock = 0;
+            analogBlocks[0].scans = 0;
+            analogBlocks[0].ready = 0;
+            analogBlocks[1].ready = 0;
+            nextSequence = 0;
+            blocksLost = 0;
+            lateScans = 0;
+            nextScanUs = micros();
+            scanRunning = 1;
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    void stopAnalogScan(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        scanRunning = 0;
+        analogBlocks[0].ready = 0;
+        analogBlocks[1].ready = 0;
+    }
+    
+    /* Responds with 1 and the oldest completed block, or 0 when none is ready
+     * or, inside a batch, the block does not fit in what is left of the
+     * response. A block is the sequence number (uint16), the micros() of its first scan
+     * (uint32), the number of scans (uint8), the number of channels (uint8),
+     * the blocks lost and the scans missed since the last block sent (uint16
+     * each), the longest a scan of the block was taken after it was due, in
+     * microseconds (uint16), then the samples (uint16), scan by scan */
+    void readAnalogBlock(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        struct analogBlock_t* block = &analogBlocks[fillBlock ^ 1];
+        uint8_T ready = block->ready &&
+                ((uint32_T)(*peripheralDataSizeResponse) + sizeof(uint8_T) + ANALOG_BLOCK_HEADER_SIZE +
+                (uint32_T)block->scans*numChannels*sizeof(uint16_T) <= CUSTOM_FUNCTION_RESPONSE_SIZE);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = ready;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        if (ready)
+        {
+            (*peripheralDataSizeResponse) += writeAnalogBlock(block, &payloadBufferTx[(*peripheralDataSizeResponse)]);
+        }
+    }
+}
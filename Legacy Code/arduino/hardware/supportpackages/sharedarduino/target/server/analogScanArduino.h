@@ -0,0 +1,53 @@
+/**
+ * @file analogScanArduino.h
+ *
+ * Provides headers to analogScanArduino.cpp
+ *
+ */
+
+#ifndef ANALOGSCANARDUINO_H
+#define ANALOGSCANARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Analog pins in one scan */
+#define ANALOG_SCAN_MAX_CHANNELS 8
+
+/* Samples held by each of the two block buffers */
+#ifndef ANALOG_SCAN_BLOCK_SAMPLES
+#if defined(ARDUINO_ARCH_AVR)
+#define ANALOG_SCAN_BLOCK_SAMPLES 32
+#else
+#define ANALOG_SCAN_BLOCK_SAMPLES 128
+#endif
+#endif
+
+/* Status returned by startAnalogScan */
+#define ANALOG_SCAN_OK          0
+#define ANALOG_SCAN_BAD_COUNT   1
+#define ANALOG_SCAN_BAD_PIN     2
+#define ANALOG_SCAN_BAD_PERIOD  3
+
+/* While pushing is on, every completed block is sent in an
+ * ANALOG_BLOCK_FRAME_START frame as readAnalogBlock returns it, without the
+ * leading status */
+
+/* Start sampling a list of analog pins at a fixed period */
+void startAnalogScan(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Stop sampling and drop the blocks not yet read */
+void stopAnalogScan(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Move the oldest completed block to the host */
+void readAnalogBlock(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Take the scans that are due and push completed blocks, called from loop() */
+void runAnalogScan(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
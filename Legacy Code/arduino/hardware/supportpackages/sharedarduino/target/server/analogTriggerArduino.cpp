@@ -0,0 +1,326 @@
+/**
+ * @file analogTriggerArduino.cpp
+ *
+ * Window comparators on analog pins, evaluated from loop(). Each pin has a
+ * low and a high threshold and reports when its reading moves below, inside
+ * or above the window, with hysteresis so that noise near a threshold does
+ * not report a crossing on every reading. A crossing into a chosen position
+ * can drive a digital output on the board straight away, as a level held
+ * while the reading stays there or as a single pulse.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "analogTriggerArduino.h"
+#include "analogConfigArduino.h"
+#include "pulseTrainArduino.h"
+#include "eventJournalArduino.h"
+#include "pushFrameArduino.h"
+#include "customFunction.h"
+    
+/* Time, pin, position and reading of a crossing on the wire */
+#define ANALOG_TRIGGER_EVENT_SIZE (sizeof(uint32_T) + 2*sizeof(uint8_T) + sizeof(uint16_T))
+    
+/* Position of a trigger that has not taken a reading yet */
+#define ANALOG_TRIGGER_UNKNOWN 0xFF
+    
+    struct analogTrigger_t
+    {
+        uint8_T pin;
+        uint8_T position;
+        uint16_T low;
+        uint16_T high;
+        uint16_T hysteresis;
+        uint32_T periodUs;
+        unsigned long nextUs;
+        uint8_T actionPin;
+        uint8_T actionPosition;
+        uint8_T actionLevel;
+        uint32_T actionPulseUs;     /* 0 holds the level while in actionPosition */
+    };
+    static struct analogTrigger_t analogTriggers[ANALOG_TRIGGER_MAX];
+    static uint8_T numTriggers = 0;
+    
+    struct analogTriggerEvent_t
+    {
+        uint32_T timeUs;
+        uint8_T pin;
+        uint8_T position;
+        uint16_T value;
+    };
+    static struct analogTriggerEvent_t triggerEvents[ANALOG_TRIGGER_QUEUE_SIZE];
+    static uint8_T triggerEventHead = 0;    /* Oldest event */
+    static uint8_T triggerEventCount = 0;
+    static uint16_T triggerEventsDropped = 0;
+    static uint8_T pushTriggerEvents = 0;
+    
+    static uint8_T windowPosition(struct analogTrigger_t* trigger, uint16_T value)
+    {
+        /* Leaving a side of the window takes hysteresis counts past its threshold */
+        if ((trigger->position == ANALOG_TRIGGER_ABOVE) && ((uint32_T)value + trigger->hysteresis >= trigger->high))
+        {
+            return ANALOG_TRIGGER_ABOVE;
+        }
+        if ((trigger->position == ANALOG_TRIGGER_BELOW) && ((uint32_T)value <= (uint32_T)trigger->low + trigger->hysteresis))
+        {
+            return ANALOG_TRIGGER_BELOW;
+        }
+        if (value >= trigger->high)
+        {
+            return ANALOG_TRIGGER_ABOVE;
+        }
+        if (value <= trigger->low)
+        {
+            return ANALOG_TRIGGER_BELOW;
+        }
+        return ANALOG_TRIGGER_INSIDE;
+    }
+    
+    static void queueTriggerEvent(uint32_T timeUs, uint8_T pin, uint8_T position, uint16_T value)
+    {
+        struct analogTriggerEvent_t* event;
+        
+        if (triggerEventCount >= ANALOG_TRIGGER_QUEUE_SIZE)
+        {
+            if (triggerEventsDropped < 0xFFFF)
+            {
+                triggerEventsDropped++;
+            }
+            return;
+        }
+        event = &triggerEvents[(triggerEventHead + triggerEventCount) % ANALOG_TRIGGER_QUEUE_SIZE];
+        event->timeUs = timeUs;
+        event->pin = pin;
+        event->position = position;
+        event->value = value;
+        triggerEventCount++;
+    }
+    
+    static void writeTriggerOutput(uint8_T pin, uint8_T level)
+    {
+        digitalWrite(pin, level ? HIGH : LOW);
+        journalEvent(JOURNAL_DIGITAL_WRITE, pin, level);
+    }
+    
+    static void runTriggerAction(struct analogTrigger_t* trigger, uint8_T oldPosition)
+    {
+        if (trigger->actionPin == ANALOG_TRIGGER_NO_ACTION)
+        {
+            return;
+        }
+        if (trigger->position == trigger->actionPosition)
+        {
+            if (trigger->actionPulseUs > 0)
+            {
+                beginPulseTrain(trigger->actionPin, trigger->actionPulseUs, 0, 1, trigger->actionLevel);
+            }
+            else
+            {
+                writeTriggerOutput(trigger->actionPin, trigger->actionLevel);
+            }
+        }
+        else if ((oldPosition == trigger->actionPosition) && (trigger->actionPulseUs == 0))
+        {
+            writeTriggerOutput(trigger->actionPin, !trigger->actionLevel);
+        }
+    }
+    
+    void runAnalogTriggers(void)
+    {
+        unsigned long now;
+        uint16_T value;
+        uint8_T oldPosition;
+        
+        for (uint8_T i = 0; i < numTriggers; i++)
+        {
+            struct analogTrigger_t* trigger = &analogTriggers[i];
+            now = micros();
+            if ((long)(now - trigger->nextUs) < 0)
+            {
+                continue;
+            }
+            trigger->nextUs = now + trigger->periodUs;
+            
+            value = (uint16_T)analogRead(trigger->pin);
+            oldPosition = trigger->position;
+            trigger->position = windowPosition(trigger, value);
+            if ((trigger->position == oldPosition) || (oldPosition == ANALOG_TRIGGER_UNKNOWN))
+            {
+                continue;
+            }
+            /* The output goes first, the report can wait for the host */
+            runTriggerAction(trigger, oldPosition);
+            queueTriggerEvent(now, trigger->pin, trigger->position, value);
+        }
+    }
+    
+    /* Payload: pin (uint8), enable (uint8), low and high thresholds and
+     * hysteresis in counts (uint16 each), period between readings in us
+     * (uint32, 0 reads on every pass of loop()), output pin (uint8,
+     * ANALOG_TRIGGER_NO_ACTION for none), position that drives it (uint8),
+     * its level (uint8) and pulse width in us (uint32, 0 holds the level
+     * while the reading stays in that position). Responds with an
+     * ANALOG_TRIGGER_ status */
+    void configureAnalogTrigger(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        struct analogTrigger_t config;
+        struct analogTrigger_t* trigger = NULL;
+        uint16_T index = 0;
+        uint8_T enable, i, oldPosition, status = ANALOG_TRIGGER_OK;
+        
+        memcpy(&config.pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&enable, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&config.low, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&config.high, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&config.hysteresis, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&config.periodUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&config.actionPin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&config.actionPosition, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&config.actionLevel, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&config.actionPulseUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        for (i = 0; i < numTriggers; i++)
+        {
+            if (analogTriggers[i].pin == config.pin)
+            {
+                trigger = &analogTriggers[i];
+                break;
+            }
+        }
+        
+        if (!enable)
+        {
+            if (trigger != NULL)
+            {
+                /* Release a level held by the trigger being removed */
+                oldPosition = trigger->position;
+                trigger->position = ANALOG_TRIGGER_UNKNOWN;
+                runTriggerAction(trigger, oldPosition);
+                numTriggers--;
+                *trigger = analogTriggers[numTriggers];
+            }
+        }
+        else if (config.pin > IO_ANALOGINPUT_MODULES_MAX)
+        {
+            status = ANALOG_TRIGGER_BAD_PIN;
+        }
+        else if (config.low > config.high)
+        {
+            status = ANALOG_TRIGGER_BAD_WINDOW;
+        }
+        else if ((trigger == NULL) && (numTriggers >= ANALOG_TRIGGER_MAX))
+        {
+            status = ANALOG_TRIGGER_NO_SLOT;
+        }
+        else
+        {
+            if (trigger == NULL)
+            {
+                trigger = &analogTriggers[numTriggers++];
+            }
+            *trigger = config;
+            /* The first reading sets the position without reporting a crossing */
+            trigger->position = ANALOG_TRIGGER_UNKNOWN;
+            trigger->nextUs = micros();
+            applyAnalogConfig();
+            if (trigger->actionPin != ANALOG_TRIGGER_NO_ACTION)
+            {
+                pinMode(trigger->actionPin, OUTPUT);
+            }
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: push (uint8), 1 to send crossings in unsolicited frames, 0 to
+     * hold them for readAnalogTriggerEvents. Clears the queue */
+    void configureAnalogTriggerEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        memcpy(&pushTriggerEvents, &payloadBufferRx[0], sizeof(uint8_T));
+        triggerEventHead = 0;
+        triggerEventCount = 0;
+        triggerEventsDropped = 0;
+    }
+    
+    /* Crossings dropped since the last report, then the oldest crossings as
+     * long as maxEvents and size allow. Returns the bytes written */
+    static uint16_T writeTriggerEvents(uint8_T* dst, uint8_T maxEvents, uint16_T maxSize)
+    {
+        uint16_T size = sizeof(uint8_T);
+        uint8_T count = 0;
+        
+        memcpy(&dst[size], &triggerEventsDropped, sizeof(uint16_T));
+        size += sizeof(uint16_T);
+        triggerEventsDropped = 0;
+        while ((count < maxEvents) && (triggerEventCount > 0) && ((size + ANALOG_TRIGGER_EVENT_SIZE) <= maxSize))
+        {
+            struct analogTriggerEvent_t* event = &triggerEvents[triggerEventHead];
+            memcpy(&dst[size], &event->timeUs, sizeof(uint32_T));
+            size += sizeof(uint32_T);
+            dst[size++] = event->pin;
+            dst[size++] = event->position;
+            memcpy(&dst[size], &event->value, sizeof(uint16_T));
+            size += sizeof(uint16_T);
+            triggerEventHead = (uint8_T)((triggerEventHead + 1) % ANALOG_TRIGGER_QUEUE_SIZE);
+            triggerEventCount--;
+            count++;
+        }
+        dst[0] = count;
+        return size;
+    }
+    
+    /* Payload: maximum number of crossings (uint8). Responds with the number
+     * of crossings returned (uint8), the crossings dropped since the last
+     * read (uint16) and the crossings, oldest first, as time (uint32), pin
+     * (uint8), new position (uint8) and reading (uint16) */
+    void readAnalogTriggerEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T maxEvents;
+        
+        memcpy(&maxEvents, &payloadBufferRx[0], sizeof(uint8_T));
+        (*peripheralDataSizeResponse) += writeTriggerEvents(&payloadBufferTx[(*peripheralDataSizeResponse)], maxEvents,
+                (uint16_T)(CUSTOM_FUNCTION_RESPONSE_SIZE - (*peripheralDataSizeResponse)));
+    }
+    
+    void sendAnalogTriggerEvents(void)
+    {
+        uint8_T frame[3 + ANALOG_TRIGGERS_PER_FRAME*ANALOG_TRIGGER_EVENT_SIZE];
+        
+        if (!pushTriggerEvents || ((triggerEventCount == 0) && (triggerEventsDropped == 0)))
+        {
+            return;
+        }
+        sendPushFrame(ANALOG_TRIGGER_FRAME_START, frame, writeTriggerEvents(frame, ANALOG_TRIGGERS_PER_FRAME, sizeof(frame)));
+    }
+    
+#ifdef __cplusplus
+}
+#endif
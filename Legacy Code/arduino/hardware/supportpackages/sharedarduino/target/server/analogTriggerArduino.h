@@ -0,0 +1,71 @@
+/**
+ * @file analogTriggerArduino.h
+ *
+ * Provides headers to analogTriggerArduino.cpp
+ *
+ */
+
+#ifndef ANALOGTRIGGERARDUINO_H
+#define ANALOGTRIGGERARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Analog pins compared at the same time */
+#ifndef ANALOG_TRIGGER_MAX
+#if defined(ARDUINO_ARCH_AVR)
+#define ANALOG_TRIGGER_MAX 4
+#else
+#define ANALOG_TRIGGER_MAX 8
+#endif
+#endif
+
+/* Crossings held for the host */
+#ifndef ANALOG_TRIGGER_QUEUE_SIZE
+#if defined(ARDUINO_ARCH_AVR)
+#define ANALOG_TRIGGER_QUEUE_SIZE 8
+#else
+#define ANALOG_TRIGGER_QUEUE_SIZE 32
+#endif
+#endif
+
+/* Where the input is relative to the window */
+#define ANALOG_TRIGGER_BELOW    0
+#define ANALOG_TRIGGER_INSIDE   1
+#define ANALOG_TRIGGER_ABOVE    2
+
+/* No local output on a crossing */
+#define ANALOG_TRIGGER_NO_ACTION 0xFF
+
+/* Status returned by configureAnalogTrigger */
+#define ANALOG_TRIGGER_OK           0
+#define ANALOG_TRIGGER_NO_SLOT      1
+#define ANALOG_TRIGGER_BAD_PIN      2
+#define ANALOG_TRIGGER_BAD_WINDOW   3
+
+/* Payload of the ANALOG_TRIGGER_FRAME_START frames sent while pushing is on:
+ * the number of crossings (uint8), the crossings dropped since the last frame
+ * (uint16), then the crossings as time (uint32), pin (uint8), new position
+ * (uint8) and the reading that crossed (uint16) */
+#define ANALOG_TRIGGERS_PER_FRAME 8
+
+/* Set or clear the window of an analog pin and the output it drives */
+void configureAnalogTrigger(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Select whether crossings are pushed to the host or left for readAnalogTriggerEvents, and clear the queue */
+void configureAnalogTriggerEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Move the oldest crossings to the host */
+void readAnalogTriggerEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Compare the pins that are due against their windows, called from loop() */
+void runAnalogTriggers(void);
+/* Send the queued crossings when pushing is on, called from loop() between requests */
+void sendAnalogTriggerEvents(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file batchArduino.cpp
+ *
+ * Runs several pin writes, PWM updates, tones, waits and custom function calls
+ * from a single request, so that their relative timing is set by the board
+ * rather than by the round trips of the host.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "MW_digitalIO.h"
+#include "MW_PWM.h"
+#include "playToneArduino.h"
+#include "pulseTrainArduino.h"
+#include "customFunction.h"
+#include "batchArduino.h"
+    
+    /* Size of the arguments that follow an opcode, custom calls add their payload on top */
+    static uint8_T batchArgumentSize(uint8_T opcode)
+    {
+        switch (opcode)
+        {
+            case BATCH_DIGITAL_WRITE:
+                return 2*sizeof(uint8_T);
+            case BATCH_PWM_WRITE:
+                return sizeof(uint8_T) + sizeof(real32_T);
+            case BATCH_PLAY_TONE:
+                return sizeof(uint8_T) + 2*sizeof(uint16_T);
+            case BATCH_WAIT_US:
+                return sizeof(uint32_T);
+            case BATCH_CUSTOM_CALL:
+                return sizeof(uint16_T) + sizeof(uint8_T);
+            default:
+                return 0;
+        }
+    }
+    
+    /* The whole batch is checked before anything runs, so that a bad request
+     * does not leave the pins half way through a sequence */
+    static uint8_T validateBatch(uint8_T* payloadBufferRx)
+    {
+        uint16_T index = 0, requestID;
+        uint32_T waitUs, totalWaitUs = 0;
+        uint8_T count, opcode, argumentSize, callSize;
+        
+        count = payloadBufferRx[index++];
+        for (uint8_T i = 0; i < count; i++)
+        {
+            if (index >= CUSTOM_FUNCTION_RESPONSE_SIZE)
+            {
+                return BATCH_MALFORMED;
+            }
+            opcode = payloadBufferRx[index++];
+            argumentSize = batchArgumentSize(opcode);
+            if ((argumentSize == 0) || ((uint16_T)(index + argumentSize) > CUSTOM_FUNCTION_RESPONSE_SIZE))
+            {
+                return BATCH_MALFORMED;
+            }
+            if (opcode == BATCH_WAIT_US)
+            {
+                memcpy(&waitUs, &payloadBufferRx[index], sizeof(uint32_T));
+                if (waitUs > (BATCH_MAX_WAIT_US - totalWaitUs))
+                {
+                    return BATCH_WAIT_TOO_LONG;
+                }
+                totalWaitUs += waitUs;
+            }
+            else if (opcode == BATCH_CUSTOM_CALL)
+            {
+                memcpy(&requestID, &payloadBufferRx[index], sizeof(uint16_T));
+                callSize = payloadBufferRx[index + sizeof(uint16_T)];
+                if ((requestID == EXECUTE_BATCH) || ((uint16_T)(index + argumentSize + callSize) > CUSTOM_FUNCTION_RESPONSE_SIZE))
+                {
+                    return BATCH_MALFORMED;
+                }
+                index += callSize;
+            }
+            index += argumentSize;
+        }
+        return BATCH_OK;
+    }
+    
+    /* Payload: count (uint8) followed by count sub-commands, see batchArduino.h.
+     * Responds with status (uint8) and the number of sub-commands executed
+     * (uint8), then for each custom call the size (uint8) and bytes of its
+     * response. */
+    void executeBatch(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, statusIndex, sizeIndex, requestID;
+        uint32_T waitUs;
+        unsigned long startTime;
+        real32_T dutyCycle;
+        uint8_T count, executed = 0, opcode, pin, value, callSize, status;
+        
+        statusIndex = *peripheralDataSizeResponse;
+        (*peripheralDataSizeResponse) += 2*sizeof(uint8_T);
+        
+        status = validateBatch(payloadBufferRx);
+        count = (status == BATCH_OK) ? payloadBufferRx[index] : 0;
+        index += sizeof(uint8_T);
+        
+        while (executed < count)
+        {
+            opcode = payloadBufferRx[index];
+            index += sizeof(uint8_T);
+            switch (opcode)
+            {
+                case BATCH_DIGITAL_WRITE:
+                    memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+                    memcpy(&value, &payloadBufferRx[index + sizeof(uint8_T)], sizeof(uint8_T));
+                    MW_digitalIO_write((MW_Handle_Type)(pin+1), (boolean_T)(value != 0));
+                    break;
+                    
+                case BATCH_PWM_WRITE:
+                    memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+                    memcpy(&dutyCycle, &payloadBufferRx[index + sizeof(uint8_T)], sizeof(real32_T));
+                    MW_PWM_SetDutyCycle((MW_Handle_Type)(pin+1), (real_T)dutyCycle);
+                    break;
+                    
+                case BATCH_PLAY_TONE:
+                    /* Same payload as PLAYTONE */
+                    playTone(&payloadBufferRx[index], payloadBufferTx, peripheralDataSizeResponse);
+                    break;
+                    
+                case BATCH_WAIT_US:
+                    memcpy(&waitUs, &payloadBufferRx[index], sizeof(uint32_T));
+                    startTime = micros();
+                    /* Pulse trains keep running while the batch waits */
+                    while ((uint32_T)(micros() - startTime) < waitUs)
+                    {
+                        runPulseTrains();
+                    }
+                    break;
+                    
+                case BATCH_CUSTOM_CALL:
+                    memcpy(&requestID, &payloadBufferRx[index], sizeof(uint16_T));
+                    callSize = payloadBufferRx[index + sizeof(uint16_T)];
+                    /* A call whose response may not fit is not made */
+                    if ((uint32_T)(*peripheralDataSizeResponse) + sizeof(uint8_T) +
+                            customFunctionResponseSize(requestID, &payloadBufferRx[index + batchArgumentSize(opcode)]) > CUSTOM_FUNCTION_RESPONSE_SIZE)
+                    {
+                        status = BATCH_RESPONSE_FULL;
+                        count = executed;
+                        continue;
+                    }
+                    sizeIndex = *peripheralDataSizeResponse;
+                    (*peripheralDataSizeResponse) += sizeof(uint8_T);
+                    customFunctionHook(requestID, &payloadBufferRx[index + batchArgumentSize(opcode)], payloadBufferTx, peripheralDataSizeResponse);
+                    payloadBufferTx[sizeIndex] = (uint8_T)(*peripheralDataSizeResponse - sizeIndex - sizeof(uint8_T));
+                    index += callSize;
+                    break;
+            }
+            index += batchArgumentSize(opcode);
+            executed++;
+        }
+        
+        payloadBufferTx[statusIndex] = status;
+        payloadBufferTx[statusIndex + 1] = executed;
+    }
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file batchArduino.h
+ *
+ * Helper for batchArduino.cpp
+ *
+ */
+
+#ifndef BATCHARDUINO_H
+#define BATCHARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Sub-command opcodes of an EXECUTE_BATCH payload, each followed by its arguments */
+#define BATCH_DIGITAL_WRITE     0x01    /* pin (uint8), value (uint8) */
+#define BATCH_PWM_WRITE         0x02    /* pin (uint8), duty cycle in percent (real32) */
+#define BATCH_PLAY_TONE         0x03    /* pin (uint8), frequency (uint16), duration in ms (uint16) */
+#define BATCH_WAIT_US           0x04    /* microseconds (uint32) */
+#define BATCH_CUSTOM_CALL       0x05    /* request ID (uint16), payload size (uint8), payload */
+
+/* Response status */
+#define BATCH_OK                0x00
+#define BATCH_MALFORMED         0x01    /* Unknown opcode, nested batch or payload overrun */
+#define BATCH_WAIT_TOO_LONG     0x02
+#define BATCH_RESPONSE_FULL     0x03    /* Stopped before a custom call that might not fit */
+
+/* Sum of the waits in one batch, the host stops waiting for a response after a second or two */
+#ifndef BATCH_MAX_WAIT_US
+#define BATCH_MAX_WAIT_US       1000000UL
+#endif
+
+/* Execute the sub-commands of one request back to back and respond once */
+void executeBatch(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#endif
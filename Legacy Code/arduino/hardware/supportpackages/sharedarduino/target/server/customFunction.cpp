@@ -18,6 +18,23 @@
 #include "shiftRegisterArduino.h"
 #include "customFunction.h"
 #include "neopixelArduino.h"
+#include "schedulerArduino.h"
+#include "scheduler_configuration.h"
+#include "addOnLoopArduino.h"
+#include "batchArduino.h"
+#include "pulseTrainArduino.h"
+#include "eventJournalArduino.h"
+#include "portIOArduino.h"
+#include "edgeWatchArduino.h"
+#include "debounceArduino.h"
+#include "analogScanArduino.h"
+#include "analogOversampleArduino.h"
+#include "analogTriggerArduino.h"
+#include "analogBurstArduino.h"
+#include "pwmWaveformArduino.h"
+#include "i2cQueueArduino.h"
+#include "i2cRegistersArduino.h"
+#include "i2cPollArduino.h"
 
 /* Init Custom peripherals */
 void customFunctionHookInit()
@@ -117,12 +134,258 @@ void customFunctionHook(uint16_T requestID,uint8_T* payloadBufferRx, uint8_T* pa
             break;
          #endif
         
+        // Streaming scheduler START
+        case CONFIGURE_RATE_GROUP:
+            configureSchedulerRateGroup(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_SCHEDULER_STATS:
+            readSchedulerStats(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case ASSIGN_RATE_GROUP_TASK:
+            assignRateGroupTask(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Streaming scheduler END
+        
+        #if ADD_ON
+            case READ_ADDON_LOOP_STATS:
+                readAddOnLoopStats(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            
+            case SET_ADDON_LOOP_BUDGET:
+                setAddOnLoopBudget(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+        #endif
+        
+        // Batch START
+        case EXECUTE_BATCH:
+            executeBatch(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Batch END
+        
+        // Pulse train START
+        case START_PULSE_TRAIN:
+            startPulseTrain(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case STOP_PULSE_TRAIN:
+            stopPulseTrain(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_PULSE_TRAIN:
+            readPulseTrain(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Pulse train END
+        
+        // Event journal START
+        case CONFIGURE_EVENT_JOURNAL:
+            configureEventJournal(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case WATCH_JOURNAL_PIN:
+            watchJournalPin(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_EVENT_JOURNAL:
+            readEventJournal(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Event journal END
+        
+        // Port IO START
+        case WRITE_DIGITAL_PINS:
+            writeDigitalPins(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_DIGITAL_PINS:
+            readDigitalPins(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Port IO END
+        
+        // Edge watch START
+        case WATCH_EDGES:
+            watchEdges(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case CONFIGURE_EDGE_EVENTS:
+            configureEdgeEvents(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_EDGE_EVENTS:
+            readEdgeEvents(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Edge watch END
+        
+        // Debounce START
+        case CONFIGURE_DEBOUNCE:
+            configureDebounce(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Debounce END
+        
+        // Analog scan START
+        case START_ANALOG_SCAN:
+            startAnalogScan(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case STOP_ANALOG_SCAN:
+            stopAnalogScan(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_ANALOG_BLOCK:
+            readAnalogBlock(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Analog scan END
+        
+        // Oversampled analog read START
+        case READ_ANALOG_OVERSAMPLED:
+            readAnalogOversampled(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Oversampled analog read END
+        
+        // Analog trigger START
+        case CONFIGURE_ANALOG_TRIGGER:
+            configureAnalogTrigger(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case CONFIGURE_ANALOG_TRIGGER_EVENTS:
+            configureAnalogTriggerEvents(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_ANALOG_TRIGGER_EVENTS:
+            readAnalogTriggerEvents(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Analog trigger END
+        
+        // Analog burst read START
+        case READ_ANALOG_BURST:
+            readAnalogBurst(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // Analog burst read END
+        
+        // PWM waveform START
+        case START_PWM_WAVEFORM:
+            startPwmWaveform(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case STOP_PWM_WAVEFORM:
+            stopPwmWaveform(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        
+        case READ_PWM_WAVEFORM:
+            readPwmWaveform(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+        break;
+        // PWM waveform END
+        
+        #if IO_STANDARD_I2C
+            // Queued I2C transfer START
+            case QUEUE_I2C_TRANSFER:
+                queueI2CTransferRequest(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            
+            case READ_I2C_TRANSFER:
+                readI2CTransferRequest(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            // Queued I2C transfer END
+            
+            // I2C register read START
+            case READ_I2C_REGISTERS:
+                readI2CRegisters(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            // I2C register read END
+            
+            // I2C poll START
+            case CONFIGURE_I2C_POLL:
+                configureI2CPoll(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            
+            case READ_I2C_POLLS:
+                readI2CPolls(payloadBufferRx,payloadBufferTx,peripheralDataSizeResponse);
+            break;
+            // I2C poll END
+        #endif
+        
 		default:
 		
 		break;
 	}
 }
 
+/* Most bytes a request adds to the response, checked by a batch before it
+ * makes the call. Reads that fit themselves to the room left count only the
+ * part they always write */
+uint16_T customFunctionResponseSize(uint16_T requestID,uint8_T* payloadBufferRx)
+{
+	switch(requestID)
+	{
+        #if IO_CUSTOM_SERVO
+            case READ_POSITION:
+                return sizeof(uint8_T);
+        #endif
+        
+        #if IO_CUSTOM_ROTARYENCODER
+            case READ_ENCODER_COUNT:
+                return 9;
+            
+            case READ_ENCODER_SPEED:
+                // Three bytes for each encoder in the payload
+                return 3*payloadBufferRx[0];
+        #endif
+        
+        #if IO_CUSTOM_ULTRASONIC
+            case ULTRASONIC_READ:
+                return sizeof(uint32_T);
+        #endif
+        
+        #if IO_CUSTOM_SHIFTREGISTER
+            case SHIFT_REGISTER_READ:
+                // Model, data, clock, load and chip enable pins, then the number of bytes
+                return payloadBufferRx[5];
+        #endif
+        
+        case READ_SCHEDULER_STATS:
+            return sizeof(uint32_T) + sizeof(schedulerStats_T);
+        
+        #if ADD_ON
+            case READ_ADDON_LOOP_STATS:
+                return sizeof(uint8_T) + 4*sizeof(uint32_T);
+        #endif
+        
+        case EXECUTE_BATCH:
+            return CUSTOM_FUNCTION_RESPONSE_SIZE;
+        
+        case READ_PULSE_TRAIN:
+            return sizeof(uint8_T) + sizeof(uint16_T) + sizeof(uint32_T);
+        
+        case READ_EVENT_JOURNAL:
+            return sizeof(uint32_T) + 2*sizeof(uint16_T) + sizeof(uint8_T);
+        
+        case READ_DIGITAL_PINS:
+            return sizeof(uint8_T) + sizeof(uint32_T);
+        
+        case READ_EDGE_EVENTS:
+        case READ_ANALOG_TRIGGER_EVENTS:
+            return sizeof(uint16_T) + sizeof(uint8_T);
+        
+        case READ_ANALOG_OVERSAMPLED:
+            return 2*sizeof(uint8_T) + sizeof(uint16_T);
+        
+        case READ_ANALOG_BURST:
+            return sizeof(uint8_T) + 2*sizeof(uint16_T) + sizeof(uint32_T);
+        
+        case READ_PWM_WAVEFORM:
+            return sizeof(uint8_T) + sizeof(uint16_T);
+        
+        #if IO_STANDARD_I2C
+            case QUEUE_I2C_TRANSFER:
+                return 2*sizeof(uint8_T);
+        #endif
+        
+		default:
+		    // A status byte at most
+		    return sizeof(uint8_T);
+	}
+}
+
 #ifdef __cplusplus
     }
 #endif
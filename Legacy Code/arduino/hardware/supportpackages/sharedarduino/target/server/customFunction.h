@@ -11,6 +11,13 @@
 
 #include "IO_include.h"
 #include "IO_peripheralInclude.h"
+
+/* Bytes of request or response payload the IO server leaves for a custom
+ * function. Utility.m
+ * generates MAX_PACKET_SIZE as the MAXPacketSize of the host plus 16 bytes
+ * for the framing the IO server adds around the payload */
+#define CUSTOM_FUNCTION_RESPONSE_SIZE (MAX_PACKET_SIZE - 16)
+
 typedef enum customFunctionRequestID
 {
     /*===========================================
@@ -53,9 +60,78 @@ typedef enum customFunctionRequestID
     WRITE_NEOPIXEL            = 0XF152,
     #endif
     
+    // Streaming scheduler
+    CONFIGURE_RATE_GROUP     = 0xF160,
+    READ_SCHEDULER_STATS     = 0xF161,
+    ASSIGN_RATE_GROUP_TASK   = 0xF162,
+    
+    #if ADD_ON
+    // Add-on library loop() budget
+    READ_ADDON_LOOP_STATS    = 0xF170,
+    SET_ADDON_LOOP_BUDGET    = 0xF171,
+    #endif
+    
+    // Batched sub-commands
+    EXECUTE_BATCH            = 0xF180,
+    
+    // Pulse trains
+    START_PULSE_TRAIN        = 0xF190,
+    STOP_PULSE_TRAIN         = 0xF191,
+    READ_PULSE_TRAIN         = 0xF192,
+    
+    // Event journal
+    CONFIGURE_EVENT_JOURNAL  = 0xF1A0,
+    WATCH_JOURNAL_PIN        = 0xF1A1,
+    READ_EVENT_JOURNAL       = 0xF1A2,
+    
+    // Port IO
+    WRITE_DIGITAL_PINS       = 0xF1B0,
+    READ_DIGITAL_PINS        = 0xF1B1,
+    
+    // Edge watch
+    WATCH_EDGES              = 0xF1C0,
+    CONFIGURE_EDGE_EVENTS    = 0xF1C1,
+    READ_EDGE_EVENTS         = 0xF1C2,
+    
+    // Debounce
+    CONFIGURE_DEBOUNCE       = 0xF1C4,
+    
+    // Continuous analog scan
+    START_ANALOG_SCAN        = 0xF1D0,
+    STOP_ANALOG_SCAN         = 0xF1D1,
+    READ_ANALOG_BLOCK        = 0xF1D2,
+    
+    // Oversampled analog read
+    READ_ANALOG_OVERSAMPLED  = 0xF1D4,
+    
+    // Analog window triggers
+    CONFIGURE_ANALOG_TRIGGER        = 0xF1D8,
+    CONFIGURE_ANALOG_TRIGGER_EVENTS = 0xF1D9,
+    READ_ANALOG_TRIGGER_EVENTS      = 0xF1DA,
+    
+    // Analog burst read
+    READ_ANALOG_BURST        = 0xF1DC,
+    
+    // PWM waveforms
+    START_PWM_WAVEFORM       = 0xF1E0,
+    STOP_PWM_WAVEFORM        = 0xF1E1,
+    READ_PWM_WAVEFORM        = 0xF1E2,
+    
+    // Queued I2C transfers
+    QUEUE_I2C_TRANSFER       = 0xF1E8,
+    READ_I2C_TRANSFER        = 0xF1E9,
+    
+    // Batched I2C register reads
+    READ_I2C_REGISTERS       = 0xF1F0,
+    
+    // Background I2C polls
+    CONFIGURE_I2C_POLL       = 0xF1F4,
+    READ_I2C_POLLS           = 0xF1F5,
+    
 }requestIDs;
 
 void customFunctionHookInit();
 void customFunctionHook(uint16_T cmdID,uint8_T* payloadBufferRx, uint8_T* payloadBufferTx,uint16_T* peripheralDataSizeResponse);
+uint16_T customFunctionResponseSize(uint16_T cmdID,uint8_T* payloadBufferRx);
 
 #endif
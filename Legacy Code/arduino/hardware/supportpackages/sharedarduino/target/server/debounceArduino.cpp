@@ -0,0 +1,189 @@
+/**
+ * @file debounceArduino.cpp
+ *
+ * Debounce filters applied to digital inputs before their level is read or
+ * their edges are reported. A lockout filter reports the first change at
+ * once and ignores the bounces that follow, an integrator waits for the new
+ * level to hold and reports the time it was last entered. Filtered levels
+ * are sampled from the pin interrupts of edgeWatchArduino.cpp, from reads
+ * and from loop(), so an integrator settles even when nothing reads the pin.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "debounceArduino.h"
+#include "edgeWatchArduino.h"
+
+extern "C" {
+    
+    uint8_T numDebounced = 0;
+    
+    struct debounce_t
+    {
+        uint8_T pin;
+        uint8_T mode;
+        uint8_T level;          /* Filtered level */
+        uint8_T pending;        /* Integrator: the input is away from level */
+        uint32_T windowUs;
+        uint32_T sinceUs;       /* Lockout: last change taken. Integrator: when the input left level */
+    };
+    static struct debounce_t debounceFilters[DEBOUNCE_MAX_PINS];
+    
+    static struct debounce_t* findFilter(uint8_T pin)
+    {
+        for (uint8_T i = 0; i < numDebounced; i++)
+        {
+            if (debounceFilters[i].pin == pin)
+            {
+                return &debounceFilters[i];
+            }
+        }
+        return NULL;
+    }
+    
+    static uint8_T sampleFilter(struct debounce_t* filter, uint8_T level, uint32_T timeUs, uint32_T* edgeUs)
+    {
+        if (filter->mode == DEBOUNCE_LOCKOUT)
+        {
+            if ((level == filter->level) || ((uint32_T)(timeUs - filter->sinceUs) < filter->windowUs))
+            {
+                return 0;
+            }
+            filter->level = level;
+            filter->sinceUs = timeUs;
+            *edgeUs = timeUs;
+            return 1;
+        }
+        
+        if (level == filter->level)
+        {
+            filter->pending = 0;
+            return 0;
+        }
+        if (!filter->pending)
+        {
+            filter->pending = 1;
+            filter->sinceUs = timeUs;
+        }
+        if ((uint32_T)(timeUs - filter->sinceUs) < filter->windowUs)
+        {
+            return 0;
+        }
+        filter->level = level;
+        filter->pending = 0;
+        *edgeUs = filter->sinceUs;
+        return 1;
+    }
+    
+    uint8_T debounceInput(uint8_T pin, uint8_T level, uint32_T timeUs, uint32_T* edgeUs)
+    {
+        struct debounce_t* filter = (numDebounced > 0) ? findFilter(pin) : NULL;
+        if (filter == NULL)
+        {
+            *edgeUs = timeUs;
+            return 1;
+        }
+        return sampleFilter(filter, level, timeUs, edgeUs);
+    }
+    
+    uint8_T pinDebounced(uint8_T pin)
+    {
+        return (findFilter(pin) != NULL) ? 1 : 0;
+    }
+    
+    uint8_T filterLevel(uint8_T pin, uint8_T level)
+    {
+        struct debounce_t* filter = findFilter(pin);
+        uint32_T edgeUs;
+        
+        if (filter == NULL)
+        {
+            return level;
+        }
+        /* The pin interrupt feeds the same filter */
+        noInterrupts();
+        if (sampleFilter(filter, level, micros(), &edgeUs))
+        {
+            queueWatchedEdge(pin, filter->level, edgeUs);
+        }
+        level = filter->level;
+        interrupts();
+        return level;
+    }
+    
+    void runDebounceFilters(void)
+    {
+        for (uint8_T i = 0; i < numDebounced; i++)
+        {
+            filterLevel(debounceFilters[i].pin, (digitalRead(debounceFilters[i].pin) == HIGH) ? 1 : 0);
+        }
+    }
+    
+    /* Payload: pin (uint8), mode (uint8), one of DEBOUNCE_OFF, _LOCKOUT or
+     * _INTEGRATOR, window in microseconds (uint32). Responds with a DEBOUNCE_ status */
+    void configureDebounce(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0;
+        uint8_T pin, mode, status = DEBOUNCE_OK;
+        uint32_T windowUs;
+        struct debounce_t* filter;
+        
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&mode, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&windowUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        noInterrupts();
+        filter = findFilter(pin);
+        if (mode > DEBOUNCE_INTEGRATOR)
+        {
+            status = DEBOUNCE_BAD_MODE;
+        }
+        else if (mode == DEBOUNCE_OFF)
+        {
+            if (filter != NULL)
+            {
+                numDebounced--;
+                *filter = debounceFilters[numDebounced];
+            }
+        }
+        else
+        {
+            if (filter == NULL)
+            {
+                if (numDebounced < DEBOUNCE_MAX_PINS)
+                {
+                    filter = &debounceFilters[numDebounced++];
+                }
+                else
+                {
+                    status = DEBOUNCE_NO_SLOT;
+                }
+            }
+            if (filter != NULL)
+            {
+                filter->pin = pin;
+                filter->mode = mode;
+                filter->windowUs = windowUs;
+                filter->level = (digitalRead(pin) == HIGH) ? 1 : 0;
+                filter->pending = 0;
+                /* A lockout filter takes the first change straight away */
+                filter->sinceUs = micros() - windowUs;
+            }
+        }
+        interrupts();
+        /* An edge watch on the pin needs both edges while it is filtered */
+        updateEdgeWatch(pin);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+}
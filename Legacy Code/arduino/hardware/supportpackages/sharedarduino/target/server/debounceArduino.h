@@ -0,0 +1,62 @@
+/**
+ * @file debounceArduino.h
+ *
+ * Provides headers to debounceArduino.cpp
+ *
+ */
+
+#ifndef DEBOUNCEARDUINO_H
+#define DEBOUNCEARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pins that can be filtered at the same time */
+#ifndef DEBOUNCE_MAX_PINS
+#if defined(ARDUINO_ARCH_AVR)
+#define DEBOUNCE_MAX_PINS 4
+#else
+#define DEBOUNCE_MAX_PINS 8
+#endif
+#endif
+
+/* Filter types of configureDebounce */
+#define DEBOUNCE_OFF        0
+#define DEBOUNCE_LOCKOUT    1   /* Take the first change, ignore the input for the window after it */
+#define DEBOUNCE_INTEGRATOR 2   /* Take a change once the input has held the new level for the window */
+
+/* Status returned by configureDebounce */
+#define DEBOUNCE_OK         0
+#define DEBOUNCE_NO_SLOT    1
+#define DEBOUNCE_BAD_MODE   2
+
+extern uint8_T numDebounced;
+
+/* Feed a raw level seen at timeUs, from a pin interrupt or with interrupts
+ * held off. Returns 1 when the level gets through the filter, with the time
+ * of the change in *edgeUs. Pins without a filter always get through */
+uint8_T debounceInput(uint8_T pin, uint8_T level, uint32_T timeUs, uint32_T* edgeUs);
+uint8_T filterLevel(uint8_T pin, uint8_T level);
+/* Whether a pin has a filter */
+uint8_T pinDebounced(uint8_T pin);
+
+/* Filtered level of a pin from its raw level, costs one test while no pin is filtered */
+static inline uint8_T debouncedLevel(uint8_T pin, uint8_T level)
+{
+    return numDebounced ? filterLevel(pin, level) : level;
+}
+
+/* Sample the filtered pins so that held levels are taken without a read, called from loop() */
+void runDebounceFilters(void);
+/* Set the filter of a pin */
+void configureDebounce(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
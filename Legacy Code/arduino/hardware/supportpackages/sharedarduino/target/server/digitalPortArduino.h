@@ -0,0 +1,91 @@
+/**
+ * @file digitalPortArduino.h
+ *
+ * Direct access to the digital port registers, the technique
+ * rotaryEncoderArduino.cpp uses for its fast reads. Each pin maps to an input
+ * register, an output register and a bit mask, so that several pins of a port
+ * are read or written with one load or store. Boards without a known register
+ * layout have DIGITAL_PORT_DIRECT set to 0 and go through digitalRead and
+ * digitalWrite instead.
+ *
+ */
+
+#ifndef DIGITALPORTARDUINO_H
+#define DIGITALPORTARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#if defined(ARDUINO_ARCH_AVR) || defined(ARDUINO_ARCH_HOST)
+#define DIGITAL_PORT_DIRECT 1
+typedef uint8_T portWord_T;
+#elif (defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)) || defined(ARDUINO_ARCH_SAM) || defined(ESP_H)
+#define DIGITAL_PORT_DIRECT 1
+typedef uint32_T portWord_T;
+#else
+#define DIGITAL_PORT_DIRECT 0
+typedef uint32_T portWord_T;
+#endif
+
+#if DIGITAL_PORT_DIRECT
+
+/* Register the level of a pin is read from */
+static inline volatile portWord_T* pinInputRegister(uint8_T pin)
+{
+    return (volatile portWord_T*)portInputRegister(digitalPinToPort(pin));
+}
+
+/* Register the level of an output pin is written to */
+static inline volatile portWord_T* pinOutputRegister(uint8_T pin)
+{
+    return (volatile portWord_T*)portOutputRegister(digitalPinToPort(pin));
+}
+
+/* Bit of a pin in its port registers */
+static inline portWord_T pinBitMask(uint8_T pin)
+{
+    return (portWord_T)digitalPinToBitMask(pin);
+}
+
+/* Drive the set bits high and the clear bits low together. On AVR and SAMD the
+ * port is rewritten with a single store, with interrupts held off so that an
+ * ISR writing the same port cannot be undone. SAM and ESP32 have set and clear
+ * registers, which need no masking but take one store each. */
+static inline void writePortBits(volatile portWord_T* out, portWord_T set, portWord_T clear)
+{
+#if defined(ARDUINO_ARCH_AVR)
+    uint8_T oldSREG = SREG;
+    cli();
+    *out = (portWord_T)((*out & (portWord_T)~clear) | set);
+    SREG = oldSREG;
+#elif defined(ARDUINO_ARCH_SAM)
+    /* portOutputRegister() is PIO_ODSR, which only takes writes to bits
+     * enabled in PIO_OWSR */
+    Pio* pio = (Pio*)((uint8_T*)out - offsetof(Pio, PIO_ODSR));
+    pio->PIO_SODR = set;
+    pio->PIO_CODR = clear;
+#elif defined(ESP_H)
+    /* GPIO_OUT_W1TS and GPIO_OUT_W1TC follow GPIO_OUT in both banks */
+    out[1] = set;
+    out[2] = clear;
+#else
+    noInterrupts();
+    *out = (portWord_T)((*out & (portWord_T)~clear) | set);
+    interrupts();
+#endif
+}
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 1 when the pin is open through MW_digitalIO_open as an output */
+uint8_T digitalPinOpenAsOutput(uint8_T pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
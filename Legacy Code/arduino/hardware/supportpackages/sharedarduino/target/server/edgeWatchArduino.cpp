@@ -0,0 +1,349 @@
+/**
+ * @file edgeWatchArduino.cpp
+ *
+ * Input edges caught by pin interrupts. Each interrupt stamps the edge with
+ * micros() and puts it in a single-producer ring that the interrupts fill and
+ * loop() drains, so neither side takes a lock. The edges are either pushed to
+ * the host in unsolicited frames between requests, or read with
+ * readEdgeEvents by hosts that do not parse those frames.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "edgeWatchArduino.h"
+#include "digitalPortArduino.h"
+#include "debounceArduino.h"
+#include "pushFrameArduino.h"
+#include "customFunction.h"
+
+/* Time, pin and level of an edge on the wire */
+#define EDGE_EVENT_SIZE (sizeof(uint32_T) + 2*sizeof(uint8_T))
+
+extern "C" {
+    
+    struct edgeWatch_t
+    {
+        uint8_T pin;
+        uint8_T mode;               /* EDGE_WATCH_OFF when the slot is free */
+        uint8_T filtered;           /* Attached on both edges for the debounce filter of the pin */
+#if DIGITAL_PORT_DIRECT
+        volatile portWord_T* reg;
+        portWord_T mask;
+#endif
+    };
+    static struct edgeWatch_t edgeWatches[EDGE_WATCH_MAX_PINS];
+    
+    struct edgeEvent_t
+    {
+        uint32_T timeUs;
+        uint8_T pin;
+        uint8_T level;
+    };
+    /* Written at head by the interrupts only, read at tail by loop() only */
+    static volatile struct edgeEvent_t edgeQueue[EDGE_QUEUE_SIZE];
+    static volatile uint8_T edgeQueueHead = 0;
+    static volatile uint8_T edgeQueueTail = 0;
+    static volatile uint16_T edgesDropped = 0;
+    static uint8_T pushEdgeEvents = 0;
+    
+    /* Add an edge at the head, from an interrupt or with interrupts held off */
+    static void queueEdge(uint8_T pin, uint8_T level, uint32_T timeUs)
+    {
+        uint8_T next = (uint8_T)((edgeQueueHead + 1) & (EDGE_QUEUE_SIZE - 1));
+        
+        if (next == edgeQueueTail)
+        {
+            if (edgesDropped < 0xFFFF)
+            {
+                edgesDropped++;
+            }
+            return;
+        }
+        edgeQueue[edgeQueueHead].timeUs = timeUs;
+        edgeQueue[edgeQueueHead].pin = pin;
+        edgeQueue[edgeQueueHead].level = level;
+        /* Publish the entry only once it is complete */
+        edgeQueueHead = next;
+    }
+    
+    static uint8_T edgeWanted(uint8_T mode, uint8_T level)
+    {
+        return (mode == EDGE_WATCH_CHANGE) ||
+               ((mode == EDGE_WATCH_RISING) && level) ||
+               ((mode == EDGE_WATCH_FALLING) && !level);
+    }
+    
+    /* A pin without a debounce filter is attached on the edges the watch asked
+     * for, so a rising or falling edge gives the level without reading the
+     * pin, which a short pulse may already have left. A filtered pin is
+     * attached on both edges so that the filter sees every change, the edges
+     * the watch did not ask for are dropped here */
+    static void recordEdge(uint8_T slot)
+    {
+        struct edgeWatch_t* watch = &edgeWatches[slot];
+        uint32_T timeUs = micros();
+        uint8_T level;
+        
+        if (!watch->filtered && (watch->mode != EDGE_WATCH_CHANGE))
+        {
+            queueEdge(watch->pin, (watch->mode == EDGE_WATCH_RISING) ? 1 : 0, timeUs);
+            return;
+        }
+#if DIGITAL_PORT_DIRECT
+        level = ((*watch->reg) & watch->mask) ? 1 : 0;
+#else
+        level = (digitalRead(watch->pin) == HIGH) ? 1 : 0;
+#endif
+        if (debounceInput(watch->pin, level, timeUs, &timeUs) && edgeWanted(watch->mode, level))
+        {
+            queueEdge(watch->pin, level, timeUs);
+        }
+    }
+    
+    static void edgeIsr0(void) { recordEdge(0); }
+    static void edgeIsr1(void) { recordEdge(1); }
+    static void edgeIsr2(void) { recordEdge(2); }
+    static void edgeIsr3(void) { recordEdge(3); }
+#if EDGE_WATCH_MAX_PINS > 4
+    static void edgeIsr4(void) { recordEdge(4); }
+    static void edgeIsr5(void) { recordEdge(5); }
+    static void edgeIsr6(void) { recordEdge(6); }
+    static void edgeIsr7(void) { recordEdge(7); }
+#endif
+    
+    static void (* const edgeIsrs[EDGE_WATCH_MAX_PINS])(void) = {
+        edgeIsr0, edgeIsr1, edgeIsr2, edgeIsr3,
+#if EDGE_WATCH_MAX_PINS > 4
+        edgeIsr4, edgeIsr5, edgeIsr6, edgeIsr7,
+#endif
+    };
+    
+    /* Oldest queued edge, returns 0 when the queue is empty */
+    static uint8_T popEdge(struct edgeEvent_t* edge)
+    {
+        uint8_T tail = edgeQueueTail;
+        if (tail == edgeQueueHead)
+        {
+            return 0;
+        }
+        edge->timeUs = edgeQueue[tail].timeUs;
+        edge->pin = edgeQueue[tail].pin;
+        edge->level = edgeQueue[tail].level;
+        edgeQueueTail = (uint8_T)((tail + 1) & (EDGE_QUEUE_SIZE - 1));
+        return 1;
+    }
+    
+    void queueWatchedEdge(uint8_T pin, uint8_T level, uint32_T timeUs)
+    {
+        for (uint8_T slot = 0; slot < EDGE_WATCH_MAX_PINS; slot++)
+        {
+            if ((edgeWatches[slot].mode != EDGE_WATCH_OFF) && (edgeWatches[slot].pin == pin) &&
+                edgeWanted(edgeWatches[slot].mode, level))
+            {
+                queueEdge(pin, level, timeUs);
+            }
+        }
+    }
+    
+    static uint16_T takeDropped(void)
+    {
+        uint16_T dropped;
+        noInterrupts();
+        dropped = edgesDropped;
+        edgesDropped = 0;
+        interrupts();
+        return dropped;
+    }
+    
+    static void detachEdgeInterrupt(uint8_T pin)
+    {
+#if defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_SAM)
+        detachInterrupt(pin);
+#elif defined(ESP_H)
+        detachInterrupt(digitalPinToInterrupt((uint32_T)pin));
+#else
+        detachInterrupt(digitalPinToInterrupt(pin));
+#endif
+    }
+    
+#if defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_SAM)
+#define attachEdgeIsr(pin, isr, edge) attachInterrupt(pin, isr, edge)
+#elif defined(ESP_H)
+#define attachEdgeIsr(pin, isr, edge) attachInterrupt(digitalPinToInterrupt((uint32_T)pin), isr, edge)
+#else
+#define attachEdgeIsr(pin, isr, edge) attachInterrupt(digitalPinToInterrupt(pin), isr, edge)
+#endif
+    
+    static void attachEdgeInterrupt(uint8_T slot)
+    {
+        struct edgeWatch_t* watch = &edgeWatches[slot];
+        
+        watch->filtered = pinDebounced(watch->pin);
+        if (watch->filtered || (watch->mode == EDGE_WATCH_CHANGE))
+        {
+            attachEdgeIsr(watch->pin, edgeIsrs[slot], CHANGE);
+        }
+        else if (watch->mode == EDGE_WATCH_RISING)
+        {
+            attachEdgeIsr(watch->pin, edgeIsrs[slot], RISING);
+        }
+        else
+        {
+            attachEdgeIsr(watch->pin, edgeIsrs[slot], FALLING);
+        }
+    }
+    
+    void updateEdgeWatch(uint8_T pin)
+    {
+        for (uint8_T slot = 0; slot < EDGE_WATCH_MAX_PINS; slot++)
+        {
+            if ((edgeWatches[slot].mode != EDGE_WATCH_OFF) && (edgeWatches[slot].pin == pin) &&
+                (edgeWatches[slot].filtered != pinDebounced(pin)))
+            {
+                detachEdgeInterrupt(pin);
+                attachEdgeInterrupt(slot);
+            }
+        }
+    }
+    
+    /* Payload: pin (uint8), mode (uint8), one of EDGE_WATCH_OFF, _RISING,
+     * _FALLING or _CHANGE. Responds with an EDGE_WATCH_ status */
+    void watchEdges(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0;
+        uint8_T pin, mode, slot, freeSlot = EDGE_WATCH_MAX_PINS;
+        uint8_T status = EDGE_WATCH_OK;
+        
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&mode, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        for (slot = 0; slot < EDGE_WATCH_MAX_PINS; slot++)
+        {
+            if (edgeWatches[slot].mode == EDGE_WATCH_OFF)
+            {
+                if (freeSlot == EDGE_WATCH_MAX_PINS)
+                {
+                    freeSlot = slot;
+                }
+            }
+            else if (edgeWatches[slot].pin == pin)
+            {
+                break;
+            }
+        }
+        
+        if (mode > EDGE_WATCH_CHANGE)
+        {
+            status = EDGE_WATCH_BAD_MODE;
+        }
+        else if (slot < EDGE_WATCH_MAX_PINS)
+        {
+            /* Pin already watched, reattached below with the new mode */
+            detachEdgeInterrupt(pin);
+            edgeWatches[slot].mode = EDGE_WATCH_OFF;
+            freeSlot = slot;
+        }
+        
+        if ((mode == EDGE_WATCH_OFF) || (status != EDGE_WATCH_OK))
+        {
+            /* Nothing to attach */
+        }
+#if !defined(ARDUINO_ARCH_SAMD) && !defined(ARDUINO_ARCH_SAM) && !defined(ESP_H)
+        else if (digitalPinToInterrupt(pin) == NOT_AN_INTERRUPT)
+        {
+            status = EDGE_WATCH_NO_INTERRUPT;
+        }
+#endif
+        else if (freeSlot == EDGE_WATCH_MAX_PINS)
+        {
+            status = EDGE_WATCH_NO_SLOT;
+        }
+        else
+        {
+            edgeWatches[freeSlot].pin = pin;
+            edgeWatches[freeSlot].mode = mode;
+#if DIGITAL_PORT_DIRECT
+            edgeWatches[freeSlot].reg = pinInputRegister(pin);
+            edgeWatches[freeSlot].mask = pinBitMask(pin);
+#endif
+            attachEdgeInterrupt(freeSlot);
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: push (uint8), 1 to send edges in unsolicited frames, 0 to hold
+     * them for readEdgeEvents. Clears the queue */
+    void configureEdgeEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        memcpy(&pushEdgeEvents, &payloadBufferRx[0], sizeof(uint8_T));
+        noInterrupts();
+        edgeQueueTail = edgeQueueHead;
+        edgesDropped = 0;
+        interrupts();
+    }
+    
+    /* Payload: maximum number of edges (uint8). Responds with the edges dropped
+     * since the last read (uint16), the number of edges returned (uint8) and
+     * the edges, oldest first, as time (uint32), pin (uint8) and level (uint8) */
+    void readEdgeEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        struct edgeEvent_t edge;
+        uint16_T dropped, countIndex;
+        uint8_T maxEdges, count = 0;
+        
+        memcpy(&maxEdges, &payloadBufferRx[0], sizeof(uint8_T));
+        
+        dropped = takeDropped();
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &dropped, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += sizeof(uint16_T);
+        
+        countIndex = *peripheralDataSizeResponse;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        
+        while ((count < maxEdges) &&
+               ((*peripheralDataSizeResponse + EDGE_EVENT_SIZE) <= CUSTOM_FUNCTION_RESPONSE_SIZE) &&
+               popEdge(&edge))
+        {
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &edge.timeUs, sizeof(uint32_T));
+            (*peripheralDataSizeResponse) += sizeof(uint32_T);
+            payloadBufferTx[(*peripheralDataSizeResponse)++] = edge.pin;
+            payloadBufferTx[(*peripheralDataSizeResponse)++] = edge.level;
+            count++;
+        }
+        payloadBufferTx[countIndex] = count;
+    }
+    
+    void sendEdgeEvents(void)
+    {
+        uint8_T frame[3 + EDGE_EVENTS_PER_FRAME*EDGE_EVENT_SIZE];
+        struct edgeEvent_t edge;
+        uint16_T size = 3, dropped;
+        uint8_T count = 0;
+        
+        if (!pushEdgeEvents || ((edgeQueueTail == edgeQueueHead) && (edgesDropped == 0)))
+        {
+            return;
+        }
+        while ((count < EDGE_EVENTS_PER_FRAME) && popEdge(&edge))
+        {
+            memcpy(&frame[size], &edge.timeUs, sizeof(uint32_T));
+            size += sizeof(uint32_T);
+            frame[size++] = edge.pin;
+            frame[size++] = edge.level;
+            count++;
+        }
+        dropped = takeDropped();
+        frame[0] = count;
+        memcpy(&frame[1], &dropped, sizeof(uint16_T));
+        sendPushFrame(EDGE_EVENT_FRAME_START, frame, size);
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * @file edgeWatchArduino.h
+ *
+ * Provides headers to edgeWatchArduino.cpp
+ *
+ */
+
+#ifndef EDGEWATCHARDUINO_H
+#define EDGEWATCHARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pins watched through interrupts at the same time */
+#ifndef EDGE_WATCH_MAX_PINS
+#if defined(ARDUINO_ARCH_AVR)
+#define EDGE_WATCH_MAX_PINS 4
+#else
+#define EDGE_WATCH_MAX_PINS 8
+#endif
+#endif
+
+/* Edges held between the interrupts and the host, a power of two up to 128 */
+#ifndef EDGE_QUEUE_SIZE
+#if defined(ARDUINO_ARCH_AVR)
+#define EDGE_QUEUE_SIZE 16
+#else
+#define EDGE_QUEUE_SIZE 64
+#endif
+#endif
+
+/* Edge selection of watchEdges */
+#define EDGE_WATCH_OFF      0
+#define EDGE_WATCH_RISING   1
+#define EDGE_WATCH_FALLING  2
+#define EDGE_WATCH_CHANGE   3
+
+/* Status returned by watchEdges */
+#define EDGE_WATCH_OK           0
+#define EDGE_WATCH_NO_INTERRUPT 1
+#define EDGE_WATCH_NO_SLOT      2
+#define EDGE_WATCH_BAD_MODE     3
+
+/* Payload of the EDGE_EVENT_FRAME_START frames sent while pushing is on: the
+ * number of edges (uint8), the edges dropped since the last frame (uint16),
+ * then the edges as time (uint32), pin (uint8) and level (uint8) */
+#define EDGE_EVENTS_PER_FRAME   8
+
+/* Attach or detach the edge interrupt of a pin */
+void watchEdges(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Select whether edges are pushed to the host or left for readEdgeEvents, and clear the queue */
+void configureEdgeEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Move the oldest queued edges to the host */
+void readEdgeEvents(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Queue an edge of a watched pin found outside its interrupt, with interrupts held off */
+void queueWatchedEdge(uint8_T pin, uint8_T level, uint32_T timeUs);
+/* Attach the interrupt of a watched pin again after its debounce filter is set or cleared */
+void updateEdgeWatch(uint8_T pin);
+/* Send the queued edges when pushing is on, called from loop() between requests */
+void sendEdgeEvents(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file eventJournalArduino.cpp
+ *
+ * Ring buffer of timestamped output commands and input edges. Every entry
+ * carries the micros() at which the board acted, so the host can line its
+ * events up with external recordings without inferring timing from round
+ * trips. When the journal is full new events are dropped and counted, the
+ * entries already held stay contiguous.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "eventJournalArduino.h"
+#include "debounceArduino.h"
+#include "customFunction.h"
+
+extern "C" {
+    
+    uint8_T eventJournalMask = 0;
+    
+    static journalEntry_T eventJournal[EVENT_JOURNAL_SIZE];
+    static uint16_T journalHead = 0;    /* Oldest entry */
+    static uint16_T journalCount = 0;
+    static uint16_T journalDropped = 0;
+    
+    static uint8_T watchedPins[EVENT_JOURNAL_MAX_WATCHED];
+    static uint8_T watchedLevels[EVENT_JOURNAL_MAX_WATCHED];
+    static uint8_T numWatched = 0;
+    
+    void recordJournalEvent(uint8_T type, uint8_T id, uint16_T value)
+    {
+        if (journalCount >= EVENT_JOURNAL_SIZE)
+        {
+            if (journalDropped < 0xFFFF)
+            {
+                journalDropped++;
+            }
+            return;
+        }
+        journalEntry_T* entry = &eventJournal[(journalHead + journalCount) % EVENT_JOURNAL_SIZE];
+        entry->timeUs = micros();
+        entry->type = type;
+        entry->id = id;
+        entry->value = value;
+        journalCount++;
+    }
+    
+    void watchJournalInputs(void)
+    {
+        uint8_T level;
+        
+        if (!(eventJournalMask & (1U << JOURNAL_INPUT_EDGE)))
+        {
+            return;
+        }
+        for (uint8_T i = 0; i < numWatched; i++)
+        {
+            level = debouncedLevel(watchedPins[i], (uint8_T)digitalRead(watchedPins[i]));
+            if (level != watchedLevels[i])
+            {
+                watchedLevels[i] = level;
+                recordJournalEvent(JOURNAL_INPUT_EDGE, watchedPins[i], level);
+            }
+        }
+    }
+    
+    /* Payload: mask of the event types to journal (uint8), bit n for type n. Clears the journal */
+    void configureEventJournal(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        memcpy(&eventJournalMask, &payloadBufferRx[0], sizeof(uint8_T));
+        journalHead = 0;
+        journalCount = 0;
+        journalDropped = 0;
+        /* Edges are detected against the level at the time journaling starts */
+        for (uint8_T i = 0; i < numWatched; i++)
+        {
+            watchedLevels[i] = (uint8_T)digitalRead(watchedPins[i]);
+        }
+    }
+    
+    /* Payload: pin (uint8), watch (uint8). Responds with 1 on success, 0 when no more pins can be watched */
+    void watchJournalPin(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0;
+        uint8_T pin, watch, i, status = 1;
+        
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&watch, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        for (i = 0; i < numWatched; i++)
+        {
+            if (watchedPins[i] == pin)
+            {
+                break;
+            }
+        }
+        if (watch)
+        {
+            if (i == numWatched)
+            {
+                if (numWatched < EVENT_JOURNAL_MAX_WATCHED)
+                {
+                    watchedPins[numWatched] = pin;
+                    watchedLevels[numWatched] = (uint8_T)digitalRead(pin);
+                    numWatched++;
+                }
+                else
+                {
+                    status = 0;
+                }
+            }
+        }
+        else if (i < numWatched)
+        {
+            numWatched--;
+            watchedPins[i] = watchedPins[numWatched];
+            watchedLevels[i] = watchedLevels[numWatched];
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: maximum number of entries (uint8). Responds with the current
+     * micros() (uint32), the number of events dropped since the last read
+     * (uint16), the number of entries returned (uint8), the number still held
+     * (uint16) and the entries, oldest first, as time (uint32), type (uint8),
+     * id (uint8) and value (uint16) */
+    void readEventJournal(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint32_T now;
+        uint16_T remaining, countIndex;
+        uint8_T maxEntries, count;
+        
+        memcpy(&maxEntries, &payloadBufferRx[0], sizeof(uint8_T));
+        
+        now = micros();
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &now, sizeof(uint32_T));
+        (*peripheralDataSizeResponse) += sizeof(uint32_T);
+        
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &journalDropped, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += sizeof(uint16_T);
+        journalDropped = 0;
+        
+        countIndex = *peripheralDataSizeResponse;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T) + sizeof(uint16_T);
+        
+        count = 0;
+        while ((count < maxEntries) && (journalCount > 0) &&
+               ((*peripheralDataSizeResponse + sizeof(journalEntry_T)) <= CUSTOM_FUNCTION_RESPONSE_SIZE))
+        {
+            journalEntry_T* entry = &eventJournal[journalHead];
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &entry->timeUs, sizeof(uint32_T));
+            (*peripheralDataSizeResponse) += sizeof(uint32_T);
+            payloadBufferTx[(*peripheralDataSizeResponse)++] = entry->type;
+            payloadBufferTx[(*peripheralDataSizeResponse)++] = entry->id;
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &entry->value, sizeof(uint16_T));
+            (*peripheralDataSizeResponse) += sizeof(uint16_T);
+            journalHead = (uint16_T)((journalHead + 1) % EVENT_JOURNAL_SIZE);
+            journalCount--;
+            count++;
+        }
+        
+        remaining = journalCount;
+        payloadBufferTx[countIndex] = count;
+        memcpy(&payloadBufferTx[countIndex + 1], &remaining, sizeof(uint16_T));
+    }
+}
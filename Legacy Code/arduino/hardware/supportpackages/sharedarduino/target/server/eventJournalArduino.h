@@ -0,0 +1,71 @@
+/**
+ * @file eventJournalArduino.h
+ *
+ * Provides headers to eventJournalArduino.cpp
+ *
+ */
+
+#ifndef EVENTJOURNALARDUINO_H
+#define EVENTJOURNALARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Entries held until the host drains them, 8 bytes each */
+#ifndef EVENT_JOURNAL_SIZE
+#if defined(ARDUINO_ARCH_AVR)
+#define EVENT_JOURNAL_SIZE 32
+#else
+#define EVENT_JOURNAL_SIZE 256
+#endif
+#endif
+
+/* Pins whose input edges can be journaled */
+#define EVENT_JOURNAL_MAX_WATCHED 8
+
+/* Event types, also the bit of each type in the journal mask */
+#define JOURNAL_DIGITAL_WRITE   0
+#define JOURNAL_PWM_WRITE       1
+#define JOURNAL_TONE            2
+#define JOURNAL_INPUT_EDGE      3
+#define JOURNAL_PULSE_EDGE      4
+
+typedef struct
+{
+    uint32_T timeUs;    /* micros() when the event happened */
+    uint8_T type;
+    uint8_T id;         /* Pin for all current event types */
+    uint16_T value;     /* Level, duty cycle (0-255) or tone frequency */
+} journalEntry_T;
+
+extern uint8_T eventJournalMask;
+
+void recordJournalEvent(uint8_T type, uint8_T id, uint16_T value);
+
+/* Called from the output paths, costs one test while the type is not journaled */
+static inline void journalEvent(uint8_T type, uint8_T id, uint16_T value)
+{
+    if (eventJournalMask & (uint8_T)(1U << type))
+    {
+        recordJournalEvent(type, id, value);
+    }
+}
+
+/* Poll the watched input pins for edges, called from loop() */
+void watchJournalInputs(void);
+/* Select the event types to journal and clear the journal */
+void configureEventJournal(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Add or remove an input pin whose edges are journaled */
+void watchJournalPin(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Move the oldest entries of the journal to the host */
+void readEventJournal(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
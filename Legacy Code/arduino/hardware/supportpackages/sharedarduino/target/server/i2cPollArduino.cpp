@@ -0,0 +1,242 @@
+/**
+ * @file i2cPollArduino.cpp
+ *
+ * Register blocks of I2C devices read periodically in the background and kept
+ * with the time they were read and a sequence number. Reads are queued on
+ * the I2C transfer queue from loop(), so they share the bus with the other
+ * transfers and never hold up a request, and the host takes the latest
+ * values from the cache without waiting for the bus.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "i2cPollArduino.h"
+#include "i2cQueueArduino.h"
+#include "customFunction.h"
+    
+#if IO_STANDARD_I2C
+    
+/* State, sequence, age and length ahead of the bytes of a poll in a response */
+#define I2C_POLL_HEADER_SIZE (2*sizeof(uint8_T) + sizeof(uint16_T) + sizeof(uint32_T))
+    
+    struct i2cPoll_t
+    {
+        uint8_T state;
+        uint8_T bus;
+        uint8_T address;
+        uint8_T registerAddress;
+        uint8_T length;
+        uint8_T transfer;           /* Read in flight, or I2C_NO_TRANSFER */
+        uint16_T sequence;          /* Counts the reads that completed */
+        uint32_T periodUs;
+        unsigned long nextUs;
+        unsigned long timeUs;       /* When the value was read */
+        uint8_T data[I2C_POLL_MAX_BYTES];
+    };
+    static struct i2cPoll_t i2cPolls[MAX_I2C_POLLS];
+    static uint8_T numPolls = 0;
+    
+    static void i2cPollDone(uint8_T transfer, uint8_T state, const uint8_T* data, uint16_T length, void* context)
+    {
+        struct i2cPoll_t* poll = (struct i2cPoll_t*)context;
+        
+        /* A poll changed while its read was in flight drops the value */
+        if (poll->transfer != transfer)
+        {
+            return;
+        }
+        poll->transfer = I2C_NO_TRANSFER;
+        if (state == I2C_TRANSFER_DONE)
+        {
+            memcpy(poll->data, data, poll->length);
+            poll->timeUs = micros();
+            poll->sequence++;
+            poll->state = I2C_POLL_VALID;
+        }
+        else
+        {
+            poll->state = I2C_POLL_FAILED;
+        }
+    }
+    
+    void runI2CPolls(void)
+    {
+        unsigned long now;
+        
+        if (numPolls == 0)
+        {
+            return;
+        }
+        now = micros();
+        for (uint8_T i = 0; i < MAX_I2C_POLLS; i++)
+        {
+            struct i2cPoll_t* poll = &i2cPolls[i];
+            if ((poll->state == I2C_POLL_OFF) || (poll->transfer != I2C_NO_TRANSFER) || ((long)(now - poll->nextUs) < 0))
+            {
+                continue;
+            }
+            poll->transfer = queueI2CTransfer(poll->bus, poll->address, &poll->registerAddress, 1, poll->length, i2cPollDone, poll);
+            if (poll->transfer == I2C_NO_TRANSFER)
+            {
+                /* The queue is full, try again on the next pass */
+                continue;
+            }
+            /* A read later than the period is timed from now instead */
+            if ((uint32_T)(now - poll->nextUs) >= poll->periodUs)
+            {
+                poll->nextUs = now + poll->periodUs;
+            }
+            else
+            {
+                poll->nextUs += poll->periodUs;
+            }
+        }
+    }
+    
+    /* Payload: poll (uint8), bus (uint8), address (uint8), register (uint8),
+     * length (uint8, 0 stops the poll) and period in us (uint32). Responds
+     * with an I2C_POLL_ status */
+    void configureI2CPoll(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0;
+        uint8_T slot, bus, address, registerAddress, length, status = I2C_POLL_OK;
+        uint32_T periodUs;
+        struct i2cPoll_t* poll;
+        
+        memcpy(&slot, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&bus, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&address, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&registerAddress, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&length, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&periodUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        if (slot >= MAX_I2C_POLLS)
+        {
+            status = I2C_POLL_BAD_SLOT;
+        }
+        else if (length == 0)
+        {
+            poll = &i2cPolls[slot];
+            if (poll->state != I2C_POLL_OFF)
+            {
+                numPolls--;
+            }
+            poll->state = I2C_POLL_OFF;
+            poll->transfer = I2C_NO_TRANSFER;
+        }
+        else if (bus >= IO_I2C_MODULES_MAX)
+        {
+            status = I2C_POLL_BAD_BUS;
+        }
+        else if ((length > I2C_POLL_MAX_BYTES) || (length + I2C_POLL_HEADER_SIZE + sizeof(uint8_T) > CUSTOM_FUNCTION_RESPONSE_SIZE))
+        {
+            status = I2C_POLL_BAD_SIZE;
+        }
+        else if (periodUs < I2C_POLL_MIN_PERIOD_US)
+        {
+            status = I2C_POLL_BAD_PERIOD;
+        }
+        else
+        {
+            poll = &i2cPolls[slot];
+            if (poll->state == I2C_POLL_OFF)
+            {
+                numPolls++;
+            }
+            poll->bus = bus;
+            poll->address = address;
+            poll->registerAddress = registerAddress;
+            poll->length = length;
+            poll->periodUs = periodUs;
+            poll->transfer = I2C_NO_TRANSFER;
+            poll->sequence = 0;
+            poll->state = I2C_POLL_WAITING;
+            poll->nextUs = micros();
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: count (uint8) and the polls (uint8 each). Responds with an
+     * I2C_POLL_ status, then per poll its state (uint8), sequence (uint16),
+     * age of the value in us (uint32), length (uint8) and the value */
+    void readI2CPolls(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T count = payloadBufferRx[0];
+        uint8_T* slots = &payloadBufferRx[1];
+        /* Counted from where the response starts, which is not 0 inside a batch */
+        uint32_T responseSize = (uint32_T)(*peripheralDataSizeResponse) + sizeof(uint8_T);
+        uint8_T status = I2C_POLL_OK;
+        unsigned long now = micros();
+        
+        for (uint8_T i = 0; (i < count) && (status == I2C_POLL_OK); i++)
+        {
+            if (slots[i] >= MAX_I2C_POLLS)
+            {
+                status = I2C_POLL_BAD_SLOT;
+            }
+            else
+            {
+                responseSize += I2C_POLL_HEADER_SIZE + ((i2cPolls[slots[i]].state == I2C_POLL_OFF) ? 0 : i2cPolls[slots[i]].length);
+                if (responseSize > CUSTOM_FUNCTION_RESPONSE_SIZE)
+                {
+                    status = I2C_POLL_BAD_SIZE;
+                }
+            }
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        if (status != I2C_POLL_OK)
+        {
+            return;
+        }
+        
+        for (uint8_T i = 0; i < count; i++)
+        {
+            struct i2cPoll_t* poll = &i2cPolls[slots[i]];
+            uint8_T length = (poll->state == I2C_POLL_OFF) ? 0 : poll->length;
+            uint32_T ageUs = (poll->sequence > 0) ? (uint32_T)(now - poll->timeUs) : 0;
+            
+            payloadBufferTx[(*peripheralDataSizeResponse)] = poll->state;
+            (*peripheralDataSizeResponse) += sizeof(uint8_T);
+            
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &poll->sequence, sizeof(uint16_T));
+            (*peripheralDataSizeResponse) += sizeof(uint16_T);
+            
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &ageUs, sizeof(uint32_T));
+            (*peripheralDataSizeResponse) += sizeof(uint32_T);
+            
+            payloadBufferTx[(*peripheralDataSizeResponse)] = length;
+            (*peripheralDataSizeResponse) += sizeof(uint8_T);
+            
+            memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], poll->data, length);
+            (*peripheralDataSizeResponse) += length;
+        }
+    }
+    
+#endif //IO_STANDARD_I2C
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file i2cPollArduino.h
+ *
+ * Provides headers to i2cPollArduino.cpp
+ *
+ */
+
+#ifndef I2CPOLLARDUINO_H
+#define I2CPOLLARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Registers polled at the same time */
+#ifndef MAX_I2C_POLLS
+#if defined(ARDUINO_ARCH_AVR)
+#define MAX_I2C_POLLS 4
+#else
+#define MAX_I2C_POLLS 8
+#endif
+#endif
+
+/* Longest register block a poll keeps */
+#ifndef I2C_POLL_MAX_BYTES
+#if defined(ARDUINO_ARCH_AVR)
+#define I2C_POLL_MAX_BYTES 16
+#else
+#define I2C_POLL_MAX_BYTES 32
+#endif
+#endif
+
+/* Shortest period between the reads of a poll */
+#define I2C_POLL_MIN_PERIOD_US 1000
+
+/* State of a poll in readI2CPolls */
+#define I2C_POLL_OFF        0
+#define I2C_POLL_WAITING    1   /* No read has completed yet */
+#define I2C_POLL_VALID      2
+#define I2C_POLL_FAILED     3   /* The last read failed, any value is from the last one that did not */
+
+/* Status returned by configureI2CPoll and readI2CPolls */
+#define I2C_POLL_OK         0
+#define I2C_POLL_BAD_SLOT   1
+#define I2C_POLL_BAD_BUS    2
+#define I2C_POLL_BAD_SIZE   3
+#define I2C_POLL_BAD_PERIOD 4
+
+/* Start, change or stop the periodic read of a register block */
+void configureI2CPoll(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Return the latest values of polls without going on the bus */
+void readI2CPolls(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Queue the reads that are due, called from loop() */
+void runI2CPolls(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,293 @@
+/**
+ * @file i2cQueueArduino.cpp
+ *
+ * I2C transfers queued to run from loop() instead of holding up the request
+ * that starts them. Each transfer is a write followed by a read with a
+ * repeated start, and moves on by one step per pass of loop(): the write,
+ * at most I2C_TRANSFER_STEP_BYTES, then the read I2C_TRANSFER_STEP_BYTES at
+ * a time with repeated starts in between, so the server and streaming run
+ * between the steps of a long read. Completion is reported to a callback,
+ * or kept for the host to collect.
+ *
+ * Wire owns the TWI and SERCOM interrupts on every core, so the steps run
+ * through MW_I2C rather than from an interrupt of their own, and each step
+ * is itself a blocking Wire call: up to I2C_TRANSFER_STEP_BYTES bytes, about
+ * 3 ms at 100 kHz. What the queue buys is that nothing waits longer than one
+ * step at a time.
+ *
+ * A transfer holds the bus between its steps: MW_I2C completes it before any
+ * other transaction, and loop() completes it before the add-on libraries,
+ * which use Wire directly and cannot be told apart from the libraries that
+ * do not. Builds with add-on libraries therefore get no overlap at all: a
+ * transfer started in a pass of loop() runs to the end in that pass, before
+ * the add-on loops and the server, as if it had been issued blocking.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "i2cQueueArduino.h"
+#include "MW_I2C.h"
+#include "customFunction.h"
+    
+#if IO_STANDARD_I2C
+    
+    struct i2cTransfer_t
+    {
+        uint8_T state;
+        uint8_T bus;
+        uint8_T address;
+        uint8_T written;            /* Set once the write has gone out */
+        uint8_T fromHost;           /* Queued by queueI2CTransferRequest, collected by readI2CTransferRequest */
+        uint16_T writeLength;
+        uint16_T readLength;
+        uint16_T readDone;
+        i2cTransferCallback_T callback;
+        void* context;
+        uint8_T data[I2C_TRANSFER_MAX_BYTES];  /* The bytes to write, then the bytes read */
+    };
+    static struct i2cTransfer_t i2cTransfers[MAX_I2C_TRANSFERS];
+    
+    /* Transfers in the order they run, the head one holding the bus */
+    static uint8_T transferOrder[MAX_I2C_TRANSFERS];
+    static uint8_T transferHead = 0;
+    static uint8_T transferCount = 0;
+    
+    /* Set while a step is inside MW_I2C, whose blocking calls would otherwise complete the transfer first */
+    static uint8_T inTransferStep = 0;
+    
+    uint8_T queueI2CTransfer(uint8_T bus, uint8_T address, const uint8_T* writeData, uint16_T writeLength, uint16_T readLength, i2cTransferCallback_T callback, void* context)
+    {
+        uint8_T transfer = 0;
+        struct i2cTransfer_t* t;
+        
+        if ((transferCount == MAX_I2C_TRANSFERS) || (writeLength > I2C_TRANSFER_MAX_WRITE) ||
+                (readLength > I2C_TRANSFER_MAX_BYTES) || (MW_I2C_Open(bus, MW_I2C_MASTER) == NULL))
+        {
+            return I2C_NO_TRANSFER;
+        }
+        while ((transfer < MAX_I2C_TRANSFERS) && (i2cTransfers[transfer].state != I2C_TRANSFER_FREE))
+        {
+            transfer++;
+        }
+        if (transfer == MAX_I2C_TRANSFERS)
+        {
+            /* Every slot holds a completed transfer nobody has collected */
+            return I2C_NO_TRANSFER;
+        }
+        t = &i2cTransfers[transfer];
+        t->bus = bus;
+        t->address = address;
+        t->written = 0;
+        t->fromHost = 0;
+        t->writeLength = writeLength;
+        t->readLength = readLength;
+        t->readDone = 0;
+        t->callback = callback;
+        t->context = context;
+        if (writeLength > 0)
+        {
+            memcpy(t->data, writeData, writeLength);
+        }
+        t->state = I2C_TRANSFER_QUEUED;
+        transferOrder[(transferHead + transferCount) % MAX_I2C_TRANSFERS] = transfer;
+        transferCount++;
+        return transfer;
+    }
+    
+    uint8_T i2cTransferState(uint8_T transfer)
+    {
+        return (transfer < MAX_I2C_TRANSFERS) ? i2cTransfers[transfer].state : I2C_TRANSFER_FREE;
+    }
+    
+    const uint8_T* i2cTransferData(uint8_T transfer)
+    {
+        return i2cTransfers[transfer].data;
+    }
+    
+    void releaseI2CTransfer(uint8_T transfer)
+    {
+        if ((transfer < MAX_I2C_TRANSFERS) && (i2cTransfers[transfer].state >= I2C_TRANSFER_DONE))
+        {
+            i2cTransfers[transfer].state = I2C_TRANSFER_FREE;
+        }
+    }
+    
+    static void completeI2CTransfer(struct i2cTransfer_t* t, uint8_T state)
+    {
+        transferHead = (transferHead + 1) % MAX_I2C_TRANSFERS;
+        transferCount--;
+        t->state = state;
+        if (t->callback != NULL)
+        {
+            t->callback((uint8_T)(t - i2cTransfers), state, t->data, t->readDone, t->context);
+            t->state = I2C_TRANSFER_FREE;
+        }
+    }
+    
+    /* The write first, then the read a step at a time. Every step but the
+     * last ends in a repeated start, so the bus stays with the transfer */
+    static void stepI2CTransfer(void)
+    {
+        struct i2cTransfer_t* t = &i2cTransfers[transferOrder[transferHead]];
+        MW_Handle_Type handle = (MW_Handle_Type)(t->bus + 1);
+        MW_I2C_Status_Type status;
+        uint16_T numBytes;
+        
+        t->state = I2C_TRANSFER_RUNNING;
+        inTransferStep = 1;
+        if (!t->written && ((t->writeLength > 0) || (t->readLength == 0)))
+        {
+            status = MW_I2C_MasterWrite(handle, t->address, t->data, t->writeLength, (t->readLength > 0) ? 1 : 0, 0);
+            t->written = 1;
+        }
+        else
+        {
+            numBytes = t->readLength - t->readDone;
+            if (numBytes > I2C_TRANSFER_STEP_BYTES)
+            {
+                numBytes = I2C_TRANSFER_STEP_BYTES;
+            }
+            status = MW_I2C_MasterRead(handle, t->address, &t->data[t->readDone], numBytes,
+                    (t->readDone + numBytes < t->readLength) ? 1 : 0, 0);
+            t->readDone += numBytes;
+        }
+        inTransferStep = 0;
+        
+        if (status != MW_I2C_SUCCESS)
+        {
+            completeI2CTransfer(t, I2C_TRANSFER_FAILED);
+        }
+        else if (t->readDone == t->readLength)
+        {
+            completeI2CTransfer(t, I2C_TRANSFER_DONE);
+        }
+    }
+    
+    void runI2CTransfers(void)
+    {
+        if (transferCount > 0)
+        {
+            stepI2CTransfer();
+        }
+    }
+    
+    uint8_T waitI2CTransfer(uint8_T transfer)
+    {
+        while ((transfer < MAX_I2C_TRANSFERS) && (i2cTransfers[transfer].state == I2C_TRANSFER_QUEUED ||
+                i2cTransfers[transfer].state == I2C_TRANSFER_RUNNING))
+        {
+            stepI2CTransfer();
+        }
+        return i2cTransferState(transfer);
+    }
+    
+    void finishI2CTransfer(void)
+    {
+        if (!inTransferStep && (transferCount > 0))
+        {
+            struct i2cTransfer_t* t = &i2cTransfers[transferOrder[transferHead]];
+            while (t->state == I2C_TRANSFER_RUNNING)
+            {
+                stepI2CTransfer();
+            }
+        }
+    }
+    
+    /* Payload: bus (uint8), address (uint8), write length (uint8), read
+     * length (uint8) and the bytes to write. Responds with an I2C_QUEUE_
+     * status and the transfer (uint8) */
+    void queueI2CTransferRequest(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T bus = payloadBufferRx[0];
+        uint8_T address = payloadBufferRx[1];
+        uint8_T writeLength = payloadBufferRx[2];
+        uint8_T readLength = payloadBufferRx[3];
+        uint8_T transfer = I2C_NO_TRANSFER;
+        uint8_T status = I2C_QUEUE_OK;
+        
+        if (bus >= IO_I2C_MODULES_MAX)
+        {
+            status = I2C_QUEUE_BAD_BUS;
+        }
+        else if ((writeLength > I2C_TRANSFER_MAX_WRITE) || (readLength > I2C_TRANSFER_MAX_BYTES) ||
+                (readLength + 2*sizeof(uint8_T) > CUSTOM_FUNCTION_RESPONSE_SIZE))
+        {
+            status = I2C_QUEUE_BAD_SIZE;
+        }
+        else
+        {
+            transfer = queueI2CTransfer(bus, address, &payloadBufferRx[4], writeLength, readLength, NULL, NULL);
+            if (transfer == I2C_NO_TRANSFER)
+            {
+                status = I2C_QUEUE_FULL;
+            }
+            else
+            {
+                i2cTransfers[transfer].fromHost = 1;
+            }
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = transfer;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: transfer (uint8). Responds with the I2C_TRANSFER_ state and,
+     * once done, the number of bytes read (uint8) and the bytes. A transfer
+     * is freed when it is collected done or failed, I2C_TRANSFER_NO_ROOM
+     * leaves a done transfer to be collected again */
+    void readI2CTransferRequest(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T transfer = payloadBufferRx[0];
+        uint8_T state = I2C_TRANSFER_FREE;
+        struct i2cTransfer_t* t;
+        
+        if ((transfer < MAX_I2C_TRANSFERS) && i2cTransfers[transfer].fromHost)
+        {
+            t = &i2cTransfers[transfer];
+            state = t->state;
+            /* Inside a batch the bytes may not fit, the transfer is kept for a later read */
+            if ((state == I2C_TRANSFER_DONE) &&
+                    ((uint32_T)(*peripheralDataSizeResponse) + 2*sizeof(uint8_T) + t->readLength > CUSTOM_FUNCTION_RESPONSE_SIZE))
+            {
+                state = I2C_TRANSFER_NO_ROOM;
+            }
+            if (state == I2C_TRANSFER_DONE)
+            {
+                payloadBufferTx[(*peripheralDataSizeResponse)] = state;
+                (*peripheralDataSizeResponse) += sizeof(uint8_T);
+                
+                payloadBufferTx[(*peripheralDataSizeResponse)] = (uint8_T)t->readLength;
+                (*peripheralDataSizeResponse) += sizeof(uint8_T);
+                
+                memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], t->data, t->readLength);
+                (*peripheralDataSizeResponse) += t->readLength;
+            }
+            if ((state == I2C_TRANSFER_DONE) || (state == I2C_TRANSFER_FAILED))
+            {
+                t->fromHost = 0;
+                t->state = I2C_TRANSFER_FREE;
+            }
+        }
+        if (state != I2C_TRANSFER_DONE)
+        {
+            payloadBufferTx[(*peripheralDataSizeResponse)] = state;
+            (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        }
+    }
+    
+#endif //IO_STANDARD_I2C
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file i2cQueueArduino.h
+ *
+ * Provides headers to i2cQueueArduino.cpp
+ *
+ */
+
+#ifndef I2CQUEUEARDUINO_H
+#define I2CQUEUEARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Transfers queued or waiting to be collected at the same time */
+#ifndef MAX_I2C_TRANSFERS
+#if defined(ARDUINO_ARCH_AVR)
+#define MAX_I2C_TRANSFERS 4
+#else
+#define MAX_I2C_TRANSFERS 8
+#endif
+#endif
+
+/* Largest read of one transfer */
+#ifndef I2C_TRANSFER_MAX_BYTES
+#if defined(ARDUINO_ARCH_AVR)
+#define I2C_TRANSFER_MAX_BYTES 32
+#else
+#define I2C_TRANSFER_MAX_BYTES 128
+#endif
+#endif
+
+/* Bytes read per pass of loop() */
+#ifndef I2C_TRANSFER_STEP_BYTES
+#define I2C_TRANSFER_STEP_BYTES 32
+#endif
+
+/* Largest write of one transfer. The write is a single step, since a device
+ * would take a write split in two for two writes */
+#define I2C_TRANSFER_MAX_WRITE I2C_TRANSFER_STEP_BYTES
+
+/* Returned by queueI2CTransfer when the transfer was not queued */
+#define I2C_NO_TRANSFER 0xFF
+
+/* State of a transfer */
+#define I2C_TRANSFER_FREE       0
+#define I2C_TRANSFER_QUEUED     1
+#define I2C_TRANSFER_RUNNING    2
+#define I2C_TRANSFER_DONE       3
+#define I2C_TRANSFER_FAILED     4
+#define I2C_TRANSFER_NO_ROOM    5   /* Reported only, a done transfer whose bytes do not fit in the response */
+
+/* Status returned by queueI2CTransferRequest */
+#define I2C_QUEUE_OK            0
+#define I2C_QUEUE_FULL          1
+#define I2C_QUEUE_BAD_BUS       2
+#define I2C_QUEUE_BAD_SIZE      3
+
+/* Called from loop() when a transfer completes, with I2C_TRANSFER_DONE or
+ * I2C_TRANSFER_FAILED and the bytes read. The transfer is freed on return */
+typedef void (*i2cTransferCallback_T)(uint8_T transfer, uint8_T state, const uint8_T* data, uint16_T length, void* context);
+
+/* Queue a write of writeLength bytes followed, after a repeated start, by a
+ * read of readLength bytes. Without a callback the transfer is kept when it
+ * completes, until releaseI2CTransfer. Returns the transfer, or
+ * I2C_NO_TRANSFER when the queue is full, the bus cannot be opened, the
+ * write is over I2C_TRANSFER_MAX_WRITE or the read over I2C_TRANSFER_MAX_BYTES */
+uint8_T queueI2CTransfer(uint8_T bus, uint8_T address, const uint8_T* writeData, uint16_T writeLength, uint16_T readLength, i2cTransferCallback_T callback, void* context);
+/* State of a transfer */
+uint8_T i2cTransferState(uint8_T transfer);
+/* Bytes read by a completed transfer */
+const uint8_T* i2cTransferData(uint8_T transfer);
+/* Free a completed transfer that has no callback */
+void releaseI2CTransfer(uint8_T transfer);
+/* Run the queue until a transfer completes and return its state, for callers that have to block */
+uint8_T waitI2CTransfer(uint8_T transfer);
+/* Complete the transfer holding the bus, so that a blocking MW_I2C call does not land in the middle of it.
+ * loop() calls it ahead of the add-on libraries, so with add-ons every transfer completes in the pass it starts */
+void finishI2CTransfer(void);
+/* Move the transfer at the head of the queue on by one step, called from loop() */
+void runI2CTransfers(void);
+
+/* Queue a transfer for the host */
+void queueI2CTransferRequest(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Collect a transfer queued by the host */
+void readI2CTransferRequest(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file i2cRegistersArduino.cpp
+ *
+ * Register reads of several I2C devices in one request. Each read writes the
+ * register address and reads the register after a repeated start, and the
+ * reads run back to back, so polling a handful of sensors takes one round
+ * trip of the host instead of one per register.
+ *
+ * Payload: count (uint8), then per read the bus (uint8), address (uint8),
+ * register (uint8) and length (uint8). Responds with an I2C_REGISTERS_
+ * status, then per read the MW_I2C status (uint8) and length bytes, zero when
+ * the read failed, so that every result sits where the request puts it.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "MW_I2C.h"
+#include "i2cRegistersArduino.h"
+#include "customFunction.h"
+    
+#if IO_STANDARD_I2C
+    
+/* Bus, address, register and length of a read */
+#define I2C_REGISTERS_READ_SIZE 4
+    
+    /* All reads are checked before any of them goes on the bus, against the
+     * response from where it starts, which is not 0 inside a batch */
+    static uint8_T checkI2CRegisterReads(uint8_T count, const uint8_T* reads, uint16_T responseStart)
+    {
+        uint32_T responseSize = (uint32_T)responseStart + sizeof(uint8_T);
+        
+        if ((count == 0) || (count > I2C_REGISTERS_MAX_READS))
+        {
+            return I2C_REGISTERS_BAD_COUNT;
+        }
+        for (uint8_T i = 0; i < count; i++)
+        {
+            if (reads[i*I2C_REGISTERS_READ_SIZE] >= IO_I2C_MODULES_MAX)
+            {
+                return I2C_REGISTERS_BAD_BUS;
+            }
+            responseSize += sizeof(uint8_T) + reads[i*I2C_REGISTERS_READ_SIZE + 3];
+        }
+        return (responseSize > CUSTOM_FUNCTION_RESPONSE_SIZE) ? I2C_REGISTERS_BAD_SIZE : I2C_REGISTERS_OK;
+    }
+    
+    void readI2CRegisters(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T count = payloadBufferRx[0];
+        const uint8_T* reads = &payloadBufferRx[1];
+        uint8_T status = checkI2CRegisterReads(count, reads, *peripheralDataSizeResponse);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        if (status != I2C_REGISTERS_OK)
+        {
+            return;
+        }
+        
+        for (uint8_T i = 0; i < count; i++)
+        {
+            uint8_T bus = reads[i*I2C_REGISTERS_READ_SIZE];
+            uint8_T address = reads[i*I2C_REGISTERS_READ_SIZE + 1];
+            uint8_T registerAddress = reads[i*I2C_REGISTERS_READ_SIZE + 2];
+            uint8_T length = reads[i*I2C_REGISTERS_READ_SIZE + 3];
+            uint8_T* result = &payloadBufferTx[(*peripheralDataSizeResponse) + sizeof(uint8_T)];
+            MW_Handle_Type handle = MW_I2C_Open(bus, MW_I2C_MASTER);
+            MW_I2C_Status_Type readStatus;
+            
+            /* A read of no bytes only writes the register address */
+            readStatus = MW_I2C_MasterWrite(handle, address, &registerAddress, 1, (length > 0) ? 1 : 0, 0);
+            if ((readStatus == MW_I2C_SUCCESS) && (length > 0))
+            {
+                readStatus = MW_I2C_MasterRead(handle, address, result, length, 0, 0);
+            }
+            if (readStatus != MW_I2C_SUCCESS)
+            {
+                memset(result, 0, length);
+            }
+            
+            payloadBufferTx[(*peripheralDataSizeResponse)] = (uint8_T)readStatus;
+            (*peripheralDataSizeResponse) += sizeof(uint8_T) + length;
+        }
+    }
+    
+#endif //IO_STANDARD_I2C
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+/**
+ * @file i2cRegistersArduino.h
+ *
+ * Helper for i2cRegistersArduino.cpp
+ *
+ */
+
+#ifndef I2CREGISTERSARDUINO_H
+#define I2CREGISTERSARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Register reads in one request */
+#define I2C_REGISTERS_MAX_READS 16
+
+/* Status of the request, ahead of the results */
+#define I2C_REGISTERS_OK        0
+#define I2C_REGISTERS_BAD_COUNT 1
+#define I2C_REGISTERS_BAD_BUS   2
+#define I2C_REGISTERS_BAD_SIZE  3   /* The results would not fit the response */
+
+/* Read registers of several I2C devices back to back and respond once */
+void readI2CRegisters(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#endif
@@ -17,6 +17,7 @@ extern "C" {
 #endif
     
 #include "playToneArduino.h"
+#include "eventJournalArduino.h"
     
 
     void playTone(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
@@ -46,6 +47,7 @@ extern "C" {
         {
             tone(pin, frequency, duration);
         }
+        journalEvent(JOURNAL_TONE, pin, (frequency == 0 || duration == 0) ? 0 : frequency);
 
         
 #if DEBUG_FLAG == 2
@@ -0,0 +1,190 @@
+/**
+ * @file portIOArduino.cpp
+ *
+ * Reads and writes of up to 32 digital pins in one request. The pins are
+ * grouped by port and each port register is accessed once, so a write changes
+ * all the pins of a port at the same instant and a read samples them together.
+ * The pins of a write must already be opened as outputs with MW_digitalIO_open,
+ * a write with any other pin is refused with PORT_IO_NOT_OUTPUT.
+ *
+ * Both requests start with a pin count and the pins. Bit i of the 32-bit
+ * level word is the level of the i-th pin.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "portIOArduino.h"
+#include "digitalPortArduino.h"
+#include "eventJournalArduino.h"
+#include "debounceArduino.h"
+    
+/* More ports than any supported board has */
+#define PORT_IO_MAX_PORTS 12
+    
+    /* Check the pin count and pins at the start of a request */
+    static uint8_T checkPins(uint8_T count, const uint8_T* pins)
+    {
+        if ((count == 0) || (count > PORT_IO_MAX_PINS))
+        {
+            return PORT_IO_BAD_COUNT;
+        }
+        for (uint8_T i = 0; i < count; i++)
+        {
+            if (pins[i] > IO_DIGITALIO_MODULES_MAX)
+            {
+                return PORT_IO_BAD_PIN;
+            }
+        }
+        return PORT_IO_OK;
+    }
+    
+#if DIGITAL_PORT_DIRECT
+    /* Index of a register in the table, adding it if there is room.
+     * Returns PORT_IO_MAX_PORTS when the table is full */
+    static uint8_T findPort(volatile portWord_T** ports, uint8_T* numPorts, volatile portWord_T* reg)
+    {
+        uint8_T p = 0;
+        while ((p < *numPorts) && (ports[p] != reg))
+        {
+            p++;
+        }
+        if ((p == *numPorts) && (p < PORT_IO_MAX_PORTS))
+        {
+            ports[p] = reg;
+            (*numPorts)++;
+        }
+        return p;
+    }
+#endif
+    
+    void writeDigitalPins(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T count = payloadBufferRx[0];
+        uint8_T* pins = &payloadBufferRx[1];
+        uint32_T levels;
+        uint8_T status = checkPins(count, pins);
+        
+        /* Nothing is written unless every pin is an output, so the pins still change together */
+        for (uint8_T i = 0; (status == PORT_IO_OK) && (i < count); i++)
+        {
+            if (!digitalPinOpenAsOutput(pins[i]))
+            {
+                status = PORT_IO_NOT_OUTPUT;
+            }
+        }
+        
+        if (status == PORT_IO_OK)
+        {
+            memcpy(&levels, &pins[count], sizeof(uint32_T));
+#if DIGITAL_PORT_DIRECT
+            volatile portWord_T* ports[PORT_IO_MAX_PORTS];
+            portWord_T setBits[PORT_IO_MAX_PORTS];
+            portWord_T clearBits[PORT_IO_MAX_PORTS];
+            uint8_T numPorts = 0;
+            for (uint8_T i = 0; i < count; i++)
+            {
+                volatile portWord_T* out = pinOutputRegister(pins[i]);
+                portWord_T mask = pinBitMask(pins[i]);
+                uint8_T known = numPorts;
+                uint8_T p = findPort(ports, &numPorts, out);
+                if (p == PORT_IO_MAX_PORTS)
+                {
+                    writePortBits(out, ((levels >> i) & 1UL) ? mask : 0, ((levels >> i) & 1UL) ? 0 : mask);
+                    continue;
+                }
+                if (p == known)
+                {
+                    setBits[p] = 0;
+                    clearBits[p] = 0;
+                }
+                if ((levels >> i) & 1UL)
+                {
+                    setBits[p] |= mask;
+                }
+                else
+                {
+                    clearBits[p] |= mask;
+                }
+            }
+            for (uint8_T p = 0; p < numPorts; p++)
+            {
+                writePortBits(ports[p], setBits[p], clearBits[p]);
+            }
+#else
+            for (uint8_T i = 0; i < count; i++)
+            {
+                digitalWrite(pins[i], ((levels >> i) & 1UL) ? HIGH : LOW);
+            }
+#endif
+            for (uint8_T i = 0; i < count; i++)
+            {
+                journalEvent(JOURNAL_DIGITAL_WRITE, pins[i], (uint16_T)((levels >> i) & 1UL));
+            }
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    void readDigitalPins(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T count = payloadBufferRx[0];
+        uint8_T* pins = &payloadBufferRx[1];
+        uint32_T levels = 0;
+        uint8_T status = checkPins(count, pins);
+        
+        if (status == PORT_IO_OK)
+        {
+#if DIGITAL_PORT_DIRECT
+            volatile portWord_T* ports[PORT_IO_MAX_PORTS];
+            portWord_T values[PORT_IO_MAX_PORTS];
+            uint8_T numPorts = 0;
+            for (uint8_T i = 0; i < count; i++)
+            {
+                findPort(ports, &numPorts, pinInputRegister(pins[i]));
+            }
+            /* Sample every port back to back */
+            noInterrupts();
+            for (uint8_T p = 0; p < numPorts; p++)
+            {
+                values[p] = *ports[p];
+            }
+            interrupts();
+            for (uint8_T i = 0; i < count; i++)
+            {
+                volatile portWord_T* in = pinInputRegister(pins[i]);
+                uint8_T p = findPort(ports, &numPorts, in);
+                portWord_T value = (p < PORT_IO_MAX_PORTS) ? values[p] : *in;
+                if (debouncedLevel(pins[i], (value & pinBitMask(pins[i])) ? 1 : 0))
+                {
+                    levels |= (1UL << i);
+                }
+            }
+#else
+            for (uint8_T i = 0; i < count; i++)
+            {
+                if (debouncedLevel(pins[i], (digitalRead(pins[i]) == HIGH) ? 1 : 0))
+                {
+                    levels |= (1UL << i);
+                }
+            }
+#endif
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &levels, sizeof(uint32_T));
+        (*peripheralDataSizeResponse) += sizeof(uint32_T);
+    }
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file portIOArduino.h
+ *
+ * Helper for portIOArduino.cpp
+ *
+ */
+
+#ifndef PORTIOARDUINO_H
+#define PORTIOARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Pins in one port request, one bit each in the 32-bit level word */
+#define PORT_IO_MAX_PINS 32
+
+/* Status returned ahead of the response of each port request */
+#define PORT_IO_OK          0
+#define PORT_IO_BAD_COUNT   1
+#define PORT_IO_BAD_PIN     2
+#define PORT_IO_NOT_OUTPUT  3   /* A pin of a write is not open as an output */
+
+/* Write a set of output pins, the pins of each port change together */
+void writeDigitalPins(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Read a set of pins as one 32-bit word */
+void readDigitalPins(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+
+#endif
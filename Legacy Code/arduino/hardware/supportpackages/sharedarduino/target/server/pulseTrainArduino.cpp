@@ -0,0 +1,242 @@
+/**
+ * @file pulseTrainArduino.cpp
+ *
+ * Pulse trains generated on the board: per pin a pulse width, a gap, a pulse
+ * count and a polarity. The edges are driven by runPulseTrains() from loop(),
+ * so server() is never blocked, and every edge is scheduled from the previous
+ * one rather than from when it was serviced, so that a late edge does not
+ * shift the rest of the train.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "pulseTrainArduino.h"
+#include "eventJournalArduino.h"
+    
+    struct pulseTrain_t
+    {
+        uint8_T pin;
+        uint8_T state;
+        uint8_T activeLevel;
+        uint8_T inPulse;
+        uint16_T count;             /* 0 runs until stopped */
+        uint16_T pulsesDone;
+        uint32_T widthUs;
+        uint32_T gapUs;
+        uint32_T maxLatenessUs;
+        unsigned long nextEdge;
+    };
+    static struct pulseTrain_t pulseTrains[MAX_PULSE_TRAINS];
+    static uint8_T numRunning = 0;
+    
+    /* Train on a pin, or NULL. With allocate set a free slot is taken instead,
+     * or failing that the slot of a completed train */
+    static struct pulseTrain_t* findPulseTrain(uint8_T pin, uint8_T allocate)
+    {
+        struct pulseTrain_t* idleSlot = NULL;
+        struct pulseTrain_t* doneSlot = NULL;
+        for (uint8_T i = 0; i < MAX_PULSE_TRAINS; i++)
+        {
+            if (pulseTrains[i].state == PULSE_TRAIN_IDLE)
+            {
+                if (idleSlot == NULL)
+                {
+                    idleSlot = &pulseTrains[i];
+                }
+            }
+            else if (pulseTrains[i].pin == pin)
+            {
+                return &pulseTrains[i];
+            }
+            else if ((doneSlot == NULL) && (pulseTrains[i].state == PULSE_TRAIN_DONE))
+            {
+                doneSlot = &pulseTrains[i];
+            }
+        }
+        if (!allocate)
+        {
+            return NULL;
+        }
+        return (idleSlot != NULL) ? idleSlot : doneSlot;
+    }
+    
+    static void writePulseLevel(struct pulseTrain_t* train, uint8_T level)
+    {
+        digitalWrite(train->pin, level);
+        journalEvent(JOURNAL_PULSE_EDGE, train->pin, level);
+    }
+    
+    static void endPulseTrain(struct pulseTrain_t* train, uint8_T state)
+    {
+        if (train->state == PULSE_TRAIN_RUNNING)
+        {
+            numRunning--;
+        }
+        writePulseLevel(train, !train->activeLevel);
+        train->inPulse = 0;
+        train->state = state;
+    }
+    
+    void runPulseTrains(void)
+    {
+        unsigned long now, lateness;
+        uint32_T duration;
+        
+        if (numRunning == 0)
+        {
+            return;
+        }
+        now = micros();
+        for (uint8_T i = 0; i < MAX_PULSE_TRAINS; i++)
+        {
+            struct pulseTrain_t* train = &pulseTrains[i];
+            if ((train->state != PULSE_TRAIN_RUNNING) || ((long)(now - train->nextEdge) < 0))
+            {
+                continue;
+            }
+            lateness = now - train->nextEdge;
+            if (lateness > train->maxLatenessUs)
+            {
+                train->maxLatenessUs = lateness;
+            }
+            if (train->inPulse)
+            {
+                train->pulsesDone++;
+                if ((train->count != 0) && (train->pulsesDone >= train->count))
+                {
+                    endPulseTrain(train, PULSE_TRAIN_DONE);
+                    continue;
+                }
+                writePulseLevel(train, !train->activeLevel);
+                duration = train->gapUs;
+            }
+            else
+            {
+                writePulseLevel(train, train->activeLevel);
+                duration = train->widthUs;
+            }
+            train->inPulse = !train->inPulse;
+            /* An edge that is later than the next phase is long would squeeze
+             * that phase to nothing, start it from now instead */
+            if (lateness >= duration)
+            {
+                train->nextEdge = now + duration;
+            }
+            else
+            {
+                train->nextEdge += duration;
+            }
+        }
+    }
+    
+    uint8_T beginPulseTrain(uint8_T pin, uint32_T widthUs, uint32_T gapUs, uint16_T count, uint8_T activeLevel)
+    {
+        struct pulseTrain_t* train = findPulseTrain(pin, 1);
+        
+        if ((train == NULL) || (widthUs == 0))
+        {
+            return 0;
+        }
+        /* Starting a pin that is already running restarts its train */
+        if (train->state == PULSE_TRAIN_RUNNING)
+        {
+            numRunning--;
+        }
+        train->pin = pin;
+        train->activeLevel = (activeLevel != 0) ? HIGH : LOW;
+        train->widthUs = widthUs;
+        train->gapUs = gapUs;
+        train->count = count;
+        train->pulsesDone = 0;
+        train->maxLatenessUs = 0;
+        pinMode(pin, OUTPUT);
+        writePulseLevel(train, train->activeLevel);
+        train->inPulse = 1;
+        train->nextEdge = micros() + widthUs;
+        train->state = PULSE_TRAIN_RUNNING;
+        numRunning++;
+        return 1;
+    }
+    
+    /* Payload: pin (uint8), width in us (uint32), gap in us (uint32), count (uint16), active level (uint8).
+     * Responds with 1 when the train started, 0 when all slots are busy or width is 0 */
+    void startPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, count;
+        uint32_T widthUs, gapUs;
+        uint8_T pin, activeLevel, status;
+        
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&widthUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&gapUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+        
+        memcpy(&count, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&activeLevel, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        status = beginPulseTrain(pin, widthUs, gapUs, count, activeLevel);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: pin (uint8) */
+    void stopPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T pin;
+        struct pulseTrain_t* train;
+        
+        memcpy(&pin, &payloadBufferRx[0], sizeof(uint8_T));
+        train = findPulseTrain(pin, 0);
+        if (train != NULL)
+        {
+            endPulseTrain(train, PULSE_TRAIN_IDLE);
+        }
+    }
+    
+    /* Payload: pin (uint8). Responds with state (uint8), pulses completed (uint16)
+     * and the latest any edge was driven in us (uint32) */
+    void readPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T pin, state = PULSE_TRAIN_IDLE;
+        uint16_T pulsesDone = 0;
+        uint32_T maxLatenessUs = 0;
+        struct pulseTrain_t* train;
+        
+        memcpy(&pin, &payloadBufferRx[0], sizeof(uint8_T));
+        train = findPulseTrain(pin, 0);
+        if (train != NULL)
+        {
+            state = train->state;
+            pulsesDone = train->pulsesDone;
+            maxLatenessUs = train->maxLatenessUs;
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = state;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+        
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &pulsesDone, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += sizeof(uint16_T);
+        
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &maxLatenessUs, sizeof(uint32_T));
+        (*peripheralDataSizeResponse) += sizeof(uint32_T);
+    }
+    
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file pulseTrainArduino.h
+ *
+ * Helper for pulseTrainArduino.cpp
+ *
+ */
+
+#ifndef PULSETRAINARDUINO_H
+#define PULSETRAINARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+/* Pins that can run a pulse train at the same time */
+#ifndef MAX_PULSE_TRAINS
+#if defined(ARDUINO_ARCH_AVR)
+#define MAX_PULSE_TRAINS 4
+#else
+#define MAX_PULSE_TRAINS 8
+#endif
+#endif
+
+/* State reported by readPulseTrain */
+#define PULSE_TRAIN_IDLE    0
+#define PULSE_TRAIN_RUNNING 1
+#define PULSE_TRAIN_DONE    2
+
+/* Start a train on a pin from the board itself, returns 0 when all slots are busy or width is 0 */
+uint8_T beginPulseTrain(uint8_T pin, uint32_T widthUs, uint32_T gapUs, uint16_T count, uint8_T activeLevel);
+/* Start a train of pulses on a pin */
+void startPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Stop the train on a pin and return it to the idle level */
+void stopPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Read whether the train on a pin has completed */
+void readPulseTrain(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Drive the pin edges that are due, called from loop() and from long waits in the server */
+void runPulseTrains(void);
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file pushFrameArduino.cpp
+ *
+ * Unsolicited frames sent to the host outside of any request. They have their
+ * own start bytes, so a host reading responses can tell them apart, and a
+ * checksum, because there is no request to retry them with.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include "pushFrameArduino.h"
+
+extern "C" {
+    
+#include "rtiostream.h"
+    
+    void sendPushFrame(uint8_T start, const uint8_T* payload, uint16_T size)
+    {
+        uint8_T sum = 0;
+        size_t sizeSent;
+        
+        for (uint16_T i = 0; i < size; i++)
+        {
+            sum += payload[i];
+        }
+        rtIOStreamSend(0, &start, sizeof(uint8_T), &sizeSent);
+        rtIOStreamSend(0, payload, size, &sizeSent);
+        rtIOStreamSend(0, &sum, sizeof(uint8_T), &sizeSent);
+    }
+}
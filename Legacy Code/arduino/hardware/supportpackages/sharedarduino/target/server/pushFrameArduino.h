@@ -0,0 +1,32 @@
+/**
+ * @file pushFrameArduino.h
+ *
+ * Provides headers to pushFrameArduino.cpp
+ *
+ */
+
+#ifndef PUSHFRAMEARDUINO_H
+#define PUSHFRAMEARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start bytes of the unsolicited frames */
+#define EDGE_EVENT_FRAME_START      0xE5
+#define ANALOG_BLOCK_FRAME_START    0xE6
+#define ANALOG_TRIGGER_FRAME_START  0xE7
+
+/* Write an unsolicited frame to the rtIOStream: the start byte, the payload
+ * and the 8-bit sum of the payload bytes. Only called from loop(), between
+ * the responses of the IO server */
+void sendPushFrame(uint8_T start, const uint8_T* payload, uint16_T size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,341 @@
+/**
+ * @file pwmWaveformArduino.cpp
+ *
+ * Duty cycle waveforms generated on the board: per PWM pin a shape between a
+ * low and a high duty cycle, a cycle duration, a repeat count and the time
+ * between duty cycle updates. The updates are driven by runPwmWaveforms()
+ * from loop(). The point of the cycle is taken from the time since the
+ * waveform started, so a late update does not stretch the waveform.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "MW_PWM.h"
+#include "pwmWaveformArduino.h"
+#include "customFunction.h"
+
+/* Exponential ramps cannot reach 0, they run down to this fraction of the larger end instead */
+#define PWM_WAVEFORM_EXP_FLOOR 0.001f
+
+    struct pwmWaveform_t
+    {
+        uint8_T pin;
+        uint8_T state;
+        uint8_T shape;
+        uint8_T numPoints;
+        uint16_T repeat;            /* 0 runs until stopped */
+        uint16_T cyclesDone;
+        uint32_T durationUs;
+        uint32_T updateUs;
+        unsigned long cycleStartUs;
+        unsigned long nextUpdateUs;
+        real32_T low;
+        real32_T high;
+        real32_T logRatio;          /* Exponential ramps: log of the end over the start */
+        uint16_T table[PWM_WAVEFORM_TABLE_POINTS];
+    };
+    static struct pwmWaveform_t pwmWaveforms[MAX_PWM_WAVEFORMS];
+    static uint8_T numRunning = 0;
+
+    /* Waveform on a pin, or NULL. With allocate set a free slot is taken
+     * instead, or failing that the slot of a completed waveform */
+    static struct pwmWaveform_t* findPwmWaveform(uint8_T pin, uint8_T allocate)
+    {
+        struct pwmWaveform_t* idleSlot = NULL;
+        struct pwmWaveform_t* doneSlot = NULL;
+        for (uint8_T i = 0; i < MAX_PWM_WAVEFORMS; i++)
+        {
+            if (pwmWaveforms[i].state == PWM_WAVEFORM_IDLE)
+            {
+                if (idleSlot == NULL)
+                {
+                    idleSlot = &pwmWaveforms[i];
+                }
+            }
+            else if (pwmWaveforms[i].pin == pin)
+            {
+                return &pwmWaveforms[i];
+            }
+            else if ((doneSlot == NULL) && (pwmWaveforms[i].state == PWM_WAVEFORM_DONE))
+            {
+                doneSlot = &pwmWaveforms[i];
+            }
+        }
+        if (!allocate)
+        {
+            return NULL;
+        }
+        return (idleSlot != NULL) ? idleSlot : doneSlot;
+    }
+
+    /* Exponential ramps start from the low end, or from the floor when it is 0 */
+    static real32_T expStart(struct pwmWaveform_t* waveform)
+    {
+        real32_T minimum = PWM_WAVEFORM_EXP_FLOOR * ((waveform->low > waveform->high) ? waveform->low : waveform->high);
+        return (waveform->low > minimum) ? waveform->low : minimum;
+    }
+
+    /* Duty cycle in percent at a point of the cycle, 0 <= phase < 1 */
+    static real32_T waveformDuty(struct pwmWaveform_t* waveform, real32_T phase)
+    {
+        real32_T span = waveform->high - waveform->low;
+        real32_T position, fraction;
+        uint8_T point;
+
+        switch (waveform->shape)
+        {
+            case PWM_WAVEFORM_LINEAR:
+                return waveform->low + span*phase;
+
+            case PWM_WAVEFORM_EXPONENTIAL:
+                return expStart(waveform)*expf(waveform->logRatio*phase);
+
+            case PWM_WAVEFORM_SINE:
+                return waveform->low + span*0.5f*(1.0f - cosf(6.2831853f*phase));
+
+            case PWM_WAVEFORM_TRIANGLE:
+                return waveform->low + span*((phase < 0.5f) ? (2.0f*phase) : (2.0f - 2.0f*phase));
+
+            default:
+                /* The last point leads back to the first */
+                position = phase*waveform->numPoints;
+                point = (uint8_T)position;
+                if (point >= waveform->numPoints)
+                {
+                    point = waveform->numPoints - 1;
+                }
+                fraction = position - point;
+                position = waveform->table[point] +
+                        fraction*((real32_T)waveform->table[(point + 1) % waveform->numPoints] - waveform->table[point]);
+                return waveform->low + span*position/65535.0f;
+        }
+    }
+
+    /* The steps go straight to the hardware, only the first and last duty
+     * cycle of a waveform go through MW_PWM_SetDutyCycle and the journal */
+    static void writeWaveformDuty(struct pwmWaveform_t* waveform, real32_T duty)
+    {
+        writePwmDuty(waveform->pin, (real_T)duty);
+    }
+
+    /* Ramps end at the high duty cycle, the periodic shapes where they started */
+    static void endPwmWaveform(struct pwmWaveform_t* waveform)
+    {
+        numRunning--;
+        if ((waveform->shape == PWM_WAVEFORM_LINEAR) || (waveform->shape == PWM_WAVEFORM_EXPONENTIAL))
+        {
+            MW_PWM_SetDutyCycle((MW_Handle_Type)(waveform->pin + 1), (real_T)waveform->high);
+        }
+        else
+        {
+            MW_PWM_SetDutyCycle((MW_Handle_Type)(waveform->pin + 1), (real_T)waveformDuty(waveform, 0));
+        }
+        waveform->cyclesDone = waveform->repeat;
+        waveform->state = PWM_WAVEFORM_DONE;
+    }
+
+    void runPwmWaveforms(void)
+    {
+        unsigned long now, cycleEndUs;
+        uint32_T elapsed, cycles;
+
+        if (numRunning == 0)
+        {
+            return;
+        }
+        now = micros();
+        for (uint8_T i = 0; i < MAX_PWM_WAVEFORMS; i++)
+        {
+            struct pwmWaveform_t* waveform = &pwmWaveforms[i];
+            if ((waveform->state != PWM_WAVEFORM_RUNNING) || ((long)(now - waveform->nextUpdateUs) < 0))
+            {
+                continue;
+            }
+            /* Move the cycle start along so that the elapsed time never wraps */
+            elapsed = now - waveform->cycleStartUs;
+            cycles = elapsed / waveform->durationUs;
+            if ((waveform->repeat != 0) && ((uint32_T)waveform->cyclesDone + cycles >= waveform->repeat))
+            {
+                endPwmWaveform(waveform);
+                continue;
+            }
+            waveform->cycleStartUs += cycles*waveform->durationUs;
+            elapsed -= cycles*waveform->durationUs;
+            waveform->cyclesDone = (uint16_T)(((uint32_T)waveform->cyclesDone + cycles > 0xFFFF) ? 0xFFFF : (waveform->cyclesDone + cycles));
+
+            writeWaveformDuty(waveform, waveformDuty(waveform, (real32_T)elapsed/(real32_T)waveform->durationUs));
+
+            /* An update later than the update period is taken from now instead */
+            if ((uint32_T)(now - waveform->nextUpdateUs) >= waveform->updateUs)
+            {
+                waveform->nextUpdateUs = now + waveform->updateUs;
+            }
+            else
+            {
+                waveform->nextUpdateUs += waveform->updateUs;
+            }
+            /* The last cycle ends on time rather than at the next update */
+            cycleEndUs = waveform->cycleStartUs + waveform->durationUs;
+            if ((waveform->repeat != 0) && (waveform->cyclesDone + 1 == waveform->repeat) &&
+                    ((long)(waveform->nextUpdateUs - cycleEndUs) > 0))
+            {
+                waveform->nextUpdateUs = cycleEndUs;
+            }
+        }
+    }
+
+    /* Payload: pin (uint8), shape (uint8), repeat count (uint16, 0 runs until
+     * stopped), cycle duration in us (uint32), time between updates in us
+     * (uint32), low and high duty cycle in percent (real32 each), number of
+     * points (uint8) and the points (uint16 each, 0 for low to 65535 for
+     * high), which only PWM_WAVEFORM_TABLE uses. Responds with a
+     * PWM_WAVEFORM_ status */
+    void startPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        struct pwmWaveform_t* waveform;
+        uint16_T index = 0, repeat;
+        uint32_T durationUs, updateUs;
+        real32_T low, high;
+        uint8_T pin, shape, numPoints, status = PWM_WAVEFORM_OK;
+
+        memcpy(&pin, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+
+        memcpy(&shape, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+
+        memcpy(&repeat, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+
+        memcpy(&durationUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+
+        memcpy(&updateUs, &payloadBufferRx[index], sizeof(uint32_T));
+        index += sizeof(uint32_T);
+
+        memcpy(&low, &payloadBufferRx[index], sizeof(real32_T));
+        index += sizeof(real32_T);
+
+        memcpy(&high, &payloadBufferRx[index], sizeof(real32_T));
+        index += sizeof(real32_T);
+
+        memcpy(&numPoints, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+
+        waveform = findPwmWaveform(pin, 1);
+        if (!pwmPinIsOpen(pin))
+        {
+            status = PWM_WAVEFORM_BAD_PIN;
+        }
+        else if ((shape > PWM_WAVEFORM_TABLE) || !(low >= 0) || !(high >= 0) || (low > 100) || (high > 100) ||
+                ((shape == PWM_WAVEFORM_EXPONENTIAL) && (low == 0) && (high == 0)))
+        {
+            /* An exponential ramp needs one end above 0 to take its ratio from */
+            status = PWM_WAVEFORM_BAD_SHAPE;
+        }
+        else if ((updateUs < PWM_WAVEFORM_MIN_UPDATE_US) || (durationUs < updateUs))
+        {
+            status = PWM_WAVEFORM_BAD_TIMING;
+        }
+        else if ((shape == PWM_WAVEFORM_TABLE) && ((numPoints < 2) || (numPoints > PWM_WAVEFORM_TABLE_POINTS) ||
+                ((uint32_T)index + numPoints*sizeof(uint16_T) > CUSTOM_FUNCTION_RESPONSE_SIZE)))
+        {
+            /* The points have to be inside the request, which is no longer than a packet */
+            status = PWM_WAVEFORM_BAD_TABLE;
+        }
+        else if (waveform == NULL)
+        {
+            status = PWM_WAVEFORM_NO_SLOT;
+        }
+
+        if (status == PWM_WAVEFORM_OK)
+        {
+            /* Starting a pin that is already running restarts its waveform */
+            if (waveform->state == PWM_WAVEFORM_RUNNING)
+            {
+                numRunning--;
+            }
+            waveform->pin = pin;
+            waveform->shape = shape;
+            waveform->repeat = repeat;
+            waveform->cyclesDone = 0;
+            waveform->durationUs = durationUs;
+            waveform->updateUs = updateUs;
+            waveform->low = low;
+            waveform->high = high;
+            waveform->numPoints = (shape == PWM_WAVEFORM_TABLE) ? numPoints : 0;
+            memcpy(waveform->table, &payloadBufferRx[index], waveform->numPoints*sizeof(uint16_T));
+            if (shape == PWM_WAVEFORM_EXPONENTIAL)
+            {
+                /* Reaches 0 at the end by way of the floor */
+                waveform->logRatio = logf(((high > 0) ? high : expStart(waveform)*PWM_WAVEFORM_EXP_FLOOR) / expStart(waveform));
+            }
+            MW_PWM_SetDutyCycle((MW_Handle_Type)(pin + 1), (real_T)waveformDuty(waveform, 0));
+            waveform->cycleStartUs = micros();
+            waveform->nextUpdateUs = waveform->cycleStartUs + updateUs;
+            waveform->state = PWM_WAVEFORM_RUNNING;
+            numRunning++;
+        }
+
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+
+    void releasePwmWaveform(uint8_T pin)
+    {
+        struct pwmWaveform_t* waveform = findPwmWaveform(pin, 0);
+
+        if (waveform != NULL)
+        {
+            if (waveform->state == PWM_WAVEFORM_RUNNING)
+            {
+                numRunning--;
+            }
+            waveform->state = PWM_WAVEFORM_IDLE;
+        }
+    }
+
+    /* Payload: pin (uint8) */
+    void stopPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T pin;
+
+        memcpy(&pin, &payloadBufferRx[0], sizeof(uint8_T));
+        releasePwmWaveform(pin);
+    }
+
+    /* Payload: pin (uint8). Responds with state (uint8) and cycles completed (uint16) */
+    void readPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T pin, state = PWM_WAVEFORM_IDLE;
+        uint16_T cyclesDone = 0;
+        struct pwmWaveform_t* waveform;
+
+        memcpy(&pin, &payloadBufferRx[0], sizeof(uint8_T));
+        waveform = findPwmWaveform(pin, 0);
+        if (waveform != NULL)
+        {
+            state = waveform->state;
+            cyclesDone = waveform->cyclesDone;
+        }
+
+        payloadBufferTx[(*peripheralDataSizeResponse)] = state;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &cyclesDone, sizeof(uint16_T));
+        (*peripheralDataSizeResponse) += sizeof(uint16_T);
+    }
+
+#ifdef __cplusplus
+}
+#endif
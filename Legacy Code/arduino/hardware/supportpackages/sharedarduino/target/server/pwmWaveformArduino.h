@@ -0,0 +1,80 @@
+/**
+ * @file pwmWaveformArduino.h
+ *
+ * Helper for pwmWaveformArduino.cpp
+ *
+ */
+
+#ifndef PWMWAVEFORMARDUINO_H
+#define PWMWAVEFORMARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PWM pins that can run a waveform at the same time */
+#ifndef MAX_PWM_WAVEFORMS
+#if defined(ARDUINO_ARCH_AVR)
+#define MAX_PWM_WAVEFORMS 4
+#else
+#define MAX_PWM_WAVEFORMS 8
+#endif
+#endif
+
+/* Points of a PWM_WAVEFORM_TABLE waveform */
+#ifndef PWM_WAVEFORM_TABLE_POINTS
+#if defined(ARDUINO_ARCH_AVR)
+#define PWM_WAVEFORM_TABLE_POINTS 16
+#else
+#define PWM_WAVEFORM_TABLE_POINTS 64
+#endif
+#endif
+
+/* Shortest time between duty cycle updates */
+#define PWM_WAVEFORM_MIN_UPDATE_US 250
+
+/* Shapes of one cycle, from the low duty cycle to the high one */
+#define PWM_WAVEFORM_LINEAR     0   /* Straight ramp from low to high */
+#define PWM_WAVEFORM_EXPONENTIAL 1  /* Ramp by a constant ratio per unit of time */
+#define PWM_WAVEFORM_SINE       2   /* Raised cosine, starting and ending at low */
+#define PWM_WAVEFORM_TRIANGLE   3   /* Up to high at half cycle and back to low */
+#define PWM_WAVEFORM_TABLE      4   /* Points spread evenly over the cycle, interpolated */
+
+/* State reported by readPwmWaveform */
+#define PWM_WAVEFORM_IDLE       0
+#define PWM_WAVEFORM_RUNNING    1
+#define PWM_WAVEFORM_DONE       2
+
+/* Status returned by startPwmWaveform */
+#define PWM_WAVEFORM_OK         0
+#define PWM_WAVEFORM_NO_SLOT    1
+#define PWM_WAVEFORM_BAD_PIN    2
+#define PWM_WAVEFORM_BAD_SHAPE  3
+#define PWM_WAVEFORM_BAD_TIMING 4
+#define PWM_WAVEFORM_BAD_TABLE  5
+
+/* Start a waveform on a PWM pin opened with MW_PWM_Open, other pins get PWM_WAVEFORM_BAD_PIN */
+void startPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Stop the waveform on a pin, leaving the duty cycle where it is */
+void stopPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Read whether the waveform on a pin has completed */
+void readPwmWaveform(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Update the duty cycles that are due, called from loop() */
+void runPwmWaveforms(void);
+/* Stop the waveform on a pin, if any, called by MW_PWM_Close */
+void releasePwmWaveform(uint8_T pin);
+
+/* Provided by MW_PWM.cpp */
+/* 1 between MW_PWM_Open and MW_PWM_Close of a pin */
+uint8_T pwmPinIsOpen(uint8_T pin);
+/* Drive a pin at a duty cycle in percent like MW_PWM_SetDutyCycle, without journaling it */
+void writePwmDuty(uint8_T pin, real_T dutyCycle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
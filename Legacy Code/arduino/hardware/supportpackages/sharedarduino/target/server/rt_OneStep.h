@@ -5,5 +5,15 @@ extern uint8_T StreamingModeFlag;
 // This is executed every time interrupt is called or every time soft real time loop is executed
 void rt_OneStep(void)
 {
-	serverScheduler();
+	uint8_T group;
+	unsigned long startTime = micros();
+	for(group = 0; group < MW_SCHEDULER_RATE_GROUPS; group++)
+	{
+		// Rate group 0 also carries the streaming list of the IO server
+		if(rateGroupStep(group) && (group == 0))
+		{
+			serverScheduler();
+		}
+	}
+	recordSchedulerExecution(micros() - startTime);
 }
\ No newline at end of file
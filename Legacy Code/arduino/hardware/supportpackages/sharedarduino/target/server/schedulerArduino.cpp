@@ -0,0 +1,117 @@
+/**
+ * @file schedulerArduino.cpp
+ *
+ * Host access to the rate groups of the streaming scheduler. The streaming
+ * list of the IO server stays in group 0; the slower groups take loop() work
+ * the host moves to them, so that for instance the I2C polls of a 30 Hz
+ * sensor are looked at on a 30 Hz group instead of on every pass of loop().
+ * A moved task only runs from its group while streaming, outside streaming
+ * loop() runs it as before.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#include "scheduler_configuration.h"
+#include "schedulerArduino.h"
+#include "analogScanArduino.h"
+#include "analogTriggerArduino.h"
+#include "debounceArduino.h"
+#include "eventJournalArduino.h"
+#include "i2cPollArduino.h"
+    
+    extern unsigned long deltaT;
+    extern uint8_T StreamingModeFlag;
+    
+    /* Indexed by SCHEDULER_TASK_ */
+    static const schedulerTask_T schedulerTasks[] = {
+        runAnalogScan,
+        runAnalogTriggers,
+        runDebounceFilters,
+        watchJournalInputs,
+#if IO_STANDARD_I2C
+        runI2CPolls,
+#endif
+    };
+#define SCHEDULER_NUM_TASKS (sizeof(schedulerTasks)/sizeof(schedulerTasks[0]))
+    
+    /* Payload: group (uint8), multiple (uint16), offset (uint16). Responds with 1 on success, 0 for an invalid configuration */
+    void configureSchedulerRateGroup(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint16_T index = 0, multiple, offset;
+        uint8_T group, status;
+        
+        memcpy(&group, &payloadBufferRx[index], sizeof(uint8_T));
+        index += sizeof(uint8_T);
+        
+        memcpy(&multiple, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        memcpy(&offset, &payloadBufferRx[index], sizeof(uint16_T));
+        index += sizeof(uint16_T);
+        
+        status = configureRateGroup(group, multiple, offset);
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    /* Payload: reset flag (uint8), the counters are cleared after reading when it is set.
+     * Responds with deltaT followed by the fields of schedulerStats_T, all uint32 */
+    void readSchedulerStats(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T flag;
+        uint32_T period = (uint32_T)deltaT;
+        const schedulerStats_T* stats = getSchedulerStats();
+        
+        memcpy(&flag, &payloadBufferRx[0], sizeof(uint8_T));
+        
+        /* The counters are only written from loop(), by schedulerStepDue and
+         * rt_OneStep, so they cannot change while the server reads them */
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], &period, sizeof(uint32_T));
+        (*peripheralDataSizeResponse) += sizeof(uint32_T);
+        memcpy(&payloadBufferTx[(*peripheralDataSizeResponse)], stats, sizeof(schedulerStats_T));
+        (*peripheralDataSizeResponse) += sizeof(schedulerStats_T);
+        if(flag)
+        {
+            resetSchedulerStats();
+        }
+    }
+    
+    /* Payload: task (uint8), one of SCHEDULER_TASK_, and group (uint8), or
+     * SCHEDULER_LOOP_GROUP. Responds with 1 on success, 0 for an unknown task
+     * or group or a full group, which leaves the task on loop() */
+    void assignRateGroupTask(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
+    {
+        uint8_T task = payloadBufferRx[0];
+        uint8_T group = payloadBufferRx[1];
+        uint8_T status = 0;
+        
+        if ((task < SCHEDULER_NUM_TASKS) && ((group < MW_SCHEDULER_RATE_GROUPS) || (group == SCHEDULER_LOOP_GROUP)))
+        {
+            removeRateGroupTask(schedulerTasks[task]);
+            status = (group == SCHEDULER_LOOP_GROUP) ? 1 : addRateGroupTask(group, schedulerTasks[task]);
+        }
+        
+        payloadBufferTx[(*peripheralDataSizeResponse)] = status;
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
+    }
+    
+    void runLoopTask(schedulerTask_T task)
+    {
+        if (!StreamingModeFlag || (rateGroupOfTask(task) == MW_SCHEDULER_RATE_GROUPS))
+        {
+            task();
+        }
+    }
+    
+#ifdef __cplusplus
+}
+#endif
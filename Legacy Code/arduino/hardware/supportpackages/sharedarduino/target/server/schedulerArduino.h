@@ -0,0 +1,34 @@
+/**
+ * @file schedulerArduino.h
+ *
+ * Helper for schedulerArduino.cpp
+ *
+ */
+
+#ifndef SCHEDULERARDUINO_H
+#define SCHEDULERARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+#include "scheduler_configuration.h"
+
+/* loop() work the host can move to a rate group with ASSIGN_RATE_GROUP_TASK */
+#define SCHEDULER_TASK_ANALOG_SCAN      0
+#define SCHEDULER_TASK_ANALOG_TRIGGERS  1
+#define SCHEDULER_TASK_DEBOUNCE         2
+#define SCHEDULER_TASK_JOURNAL_INPUTS   3
+#define SCHEDULER_TASK_I2C_POLLS        4
+
+/* Group given to ASSIGN_RATE_GROUP_TASK to hand a task back to loop() */
+#define SCHEDULER_LOOP_GROUP            0xFF
+
+/* Set the multiple of the base rate and the phase offset of a rate group */
+void configureSchedulerRateGroup(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Read the step lateness histogram, execution time and overrun counters */
+void readSchedulerStats(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Move a SCHEDULER_TASK_ from loop() to a rate group, or back */
+void assignRateGroupTask(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+/* Run a task from loop(), unless a rate group runs it while streaming */
+void runLoopTask(schedulerTask_T task);
+
+#endif
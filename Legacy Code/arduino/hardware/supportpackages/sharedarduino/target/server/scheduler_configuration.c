@@ -1,25 +1,391 @@
+#include <string.h>
 #include "scheduler_configuration.h"
+#include "timerPwmArduino.h"
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
 unsigned long deltaT = 1000;
 
 uint8_T StreamingModeFlag = 0;
 
+// Used for soft Real Time implementation
+static unsigned long oldtime = 0L;
+
+typedef struct
+{
+    uint16_T multiple;      /* 0 disables the group */
+    uint16_T countdown;     /* Base rate steps until the group runs next */
+    uint8_T numTasks;
+    schedulerTask_T tasks[MW_SCHEDULER_GROUP_TASKS];
+} rateGroup_T;
+
+/* Group 0 runs at the base rate unless the host configures it otherwise */
+static rateGroup_T rateGroups[MW_SCHEDULER_RATE_GROUPS] = {{1, 0, 0, {NULL}}};
+
+static schedulerStats_T schedulerStats;
+
+/* Upper bounds in microseconds of all but the last lateness bucket */
+static const uint16_T schedulerLatenessBound[MW_SCHEDULER_LATENESS_BUCKETS - 1] = {4, 16, 64, 256, 1024, 4096, 16384};
+
+static void recordLateness(unsigned long lateness)
+{
+    uint8_T bucket = 0;
+    while ((bucket < (MW_SCHEDULER_LATENESS_BUCKETS - 1)) && (lateness >= schedulerLatenessBound[bucket]))
+    {
+        bucket++;
+    }
+    schedulerStats.latenessHistogram[bucket]++;
+    if (lateness > schedulerStats.maxLatenessUs)
+    {
+        schedulerStats.maxLatenessUs = lateness;
+    }
+    schedulerStats.numSteps++;
+}
+
+#if MW_HW_SCHEDULER
+/* The timer interrupt only counts ticks. loop() compares it against the number of
+ * ticks it has serviced, so neither side needs a critical section to hand over. */
+static volatile uint8_T schedulerTickCount = 0;
+static volatile unsigned long schedulerTickTime = 0;
+static uint8_T schedulerTickServiced = 0;
+static uint8_T schedulerTimerRunning = 0;
+
+#define SCHEDULER_TICK() do { schedulerTickTime = micros(); schedulerTickCount++; } while (0)
+
+#if defined(ARDUINO_ARCH_AVR)
+/* Uno class parts only have Timer1 as a 16-bit timer (PWM on pins 9 and 10 while
+ * streaming). On Mega class parts Servo claims Timer5, 1, 3 and 4 in that order,
+ * twelve servos each, so those use Timer4 (PWM on pins 6, 7 and 8 while
+ * streaming) and attachServo stops before Servo gets to it. Leonardo class parts
+ * use Timer3, Servo only ever takes Timer1 there. The compare B vector is used
+ * because Servo defines the compare A vectors. */
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+#define SCHEDULER_TCCRA   TCCR4A
+#define SCHEDULER_TCCRB   TCCR4B
+#define SCHEDULER_TCNT    TCNT4
+#define SCHEDULER_OCRA    OCR4A
+#define SCHEDULER_OCRB    OCR4B
+#define SCHEDULER_TIMSK   TIMSK4
+#define SCHEDULER_TIFR    TIFR4
+#define SCHEDULER_OCIEB   OCIE4B
+#define SCHEDULER_OCFB    OCF4B
+#define SCHEDULER_WGM0    WGM40
+#define SCHEDULER_WGM2    WGM42
+#define SCHEDULER_CS0     CS40
+#define SCHEDULER_CS1     CS41
+#define SCHEDULER_VECT    TIMER4_COMPB_vect
+#elif defined(__AVR_ATmega32U4__)
+#define SCHEDULER_TCCRA   TCCR3A
+#define SCHEDULER_TCCRB   TCCR3B
+#define SCHEDULER_TCNT    TCNT3
+#define SCHEDULER_OCRA    OCR3A
+#define SCHEDULER_OCRB    OCR3B
+#define SCHEDULER_TIMSK   TIMSK3
+#define SCHEDULER_TIFR    TIFR3
+#define SCHEDULER_OCIEB   OCIE3B
+#define SCHEDULER_OCFB    OCF3B
+#define SCHEDULER_WGM0    WGM30
+#define SCHEDULER_WGM2    WGM32
+#define SCHEDULER_CS0     CS30
+#define SCHEDULER_CS1     CS31
+#define SCHEDULER_VECT    TIMER3_COMPB_vect
+#else
+#define SCHEDULER_TCCRA   TCCR1A
+#define SCHEDULER_TCCRB   TCCR1B
+#define SCHEDULER_TCNT    TCNT1
+#define SCHEDULER_OCRA    OCR1A
+#define SCHEDULER_OCRB    OCR1B
+#define SCHEDULER_TIMSK   TIMSK1
+#define SCHEDULER_TIFR    TIFR1
+#define SCHEDULER_OCIEB   OCIE1B
+#define SCHEDULER_OCFB    OCF1B
+#define SCHEDULER_WGM0    WGM10
+#define SCHEDULER_WGM2    WGM12
+#define SCHEDULER_CS0     CS10
+#define SCHEDULER_CS1     CS11
+#define SCHEDULER_VECT    TIMER1_COMPB_vect
+#endif
+
+/* Clock select 1..5 of the 16-bit timers */
+static const uint16_T schedulerPrescaler[] = {1, 8, 64, 256, 1024};
+
+ISR(SCHEDULER_VECT)
+{
+    SCHEDULER_TICK();
+}
+
+#elif defined(ARDUINO_ARCH_SAMD)
+/* TC3 in 16-bit match frequency mode. TC4 and TC5 are used by Servo and tone. */
+static const uint16_T schedulerPrescaler[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+
+static void schedulerTimerSync(void)
+{
+    while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+void TC3_Handler(void)
+{
+    TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    SCHEDULER_TICK();
+}
+
+#elif defined(ARDUINO_ARCH_SAM)
+/* Channel 2 of TC2 (TC8). TC0 and TC1 are used by Servo, TC8 only drives PWM on pins 11 and 12. */
+#define SCHEDULER_TC            TC2
+#define SCHEDULER_TC_CHANNEL    2
+#define SCHEDULER_TC_IRQ        TC8_IRQn
+
+void TC8_Handler(void)
+{
+    TC_GetStatus(SCHEDULER_TC, SCHEDULER_TC_CHANNEL);
+    SCHEDULER_TICK();
+}
+
+#elif defined(ARDUINO_ARCH_ESP32)
+static hw_timer_t *schedulerTimer = NULL;
+
+static void IRAM_ATTR schedulerTimerISR(void)
+{
+    SCHEDULER_TICK();
+}
+#endif
+
+/* Program the timer for a period of periodUs microseconds without enabling its
+ * interrupt. Returns 0 if the period cannot be generated by the timer. */
+static uint8_T schedulerTimerSetup(unsigned long periodUs)
+{
+#if defined(ARDUINO_ARCH_AVR)
+    uint32_T cycles = (uint32_T)(F_CPU / 1000000UL) * periodUs;
+    uint8_T cs;
+    uint8_T oldSREG;
+    for (cs = 0; cs < sizeof(schedulerPrescaler)/sizeof(schedulerPrescaler[0]); cs++)
+    {
+        if ((cycles / schedulerPrescaler[cs]) <= 65536UL)
+        {
+            break;
+        }
+    }
+    if ((cycles == 0) || (cs == sizeof(schedulerPrescaler)/sizeof(schedulerPrescaler[0])))
+    {
+        return 0;
+    }
+    oldSREG = SREG;
+    cli();
+    SCHEDULER_TCCRB = 0;
+    SCHEDULER_TCCRA = 0;
+    SCHEDULER_TCNT = 0;
+    /* CTC with TOP = OCRA. Compare B at TOP gives one interrupt per period */
+    SCHEDULER_OCRA = (uint16_T)((cycles / schedulerPrescaler[cs]) - 1);
+    SCHEDULER_OCRB = SCHEDULER_OCRA;
+    SCHEDULER_TIFR = _BV(SCHEDULER_OCFB);
+    SCHEDULER_TCCRB = _BV(SCHEDULER_WGM2) | (uint8_T)(cs + 1);
+    SREG = oldSREG;
+    return 1;
+#elif defined(ARDUINO_ARCH_SAMD)
+    uint32_T cycles = (uint32_T)(F_CPU / 1000000UL) * periodUs;
+    uint8_T ps;
+    for (ps = 0; ps < sizeof(schedulerPrescaler)/sizeof(schedulerPrescaler[0]); ps++)
+    {
+        if ((cycles / schedulerPrescaler[ps]) <= 65536UL)
+        {
+            break;
+        }
+    }
+    if ((cycles == 0) || (ps == sizeof(schedulerPrescaler)/sizeof(schedulerPrescaler[0])))
+    {
+        return 0;
+    }
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3);
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    schedulerTimerSync();
+    TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER(ps);
+    schedulerTimerSync();
+    TC3->COUNT16.COUNT.reg = 0;
+    schedulerTimerSync();
+    TC3->COUNT16.CC[0].reg = (uint16_t)((cycles / schedulerPrescaler[ps]) - 1);
+    schedulerTimerSync();
+    TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    NVIC_ClearPendingIRQ(TC3_IRQn);
+    NVIC_EnableIRQ(TC3_IRQn);
+    TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+    schedulerTimerSync();
+    return 1;
+#elif defined(ARDUINO_ARCH_SAM)
+    /* TIMER_CLOCK1 is MCK/2 and the SAM3X counters are 32-bit wide */
+    uint32_T rc = (uint32_T)(VARIANT_MCK / 2 / 1000000UL) * periodUs;
+    if (rc == 0)
+    {
+        return 0;
+    }
+    pmc_set_writeprotect(false);
+    pmc_enable_periph_clk((uint32_t)SCHEDULER_TC_IRQ);
+    TC_Configure(SCHEDULER_TC, SCHEDULER_TC_CHANNEL, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK1);
+    TC_SetRC(SCHEDULER_TC, SCHEDULER_TC_CHANNEL, rc);
+    SCHEDULER_TC->TC_CHANNEL[SCHEDULER_TC_CHANNEL].TC_IDR = ~0UL;
+    NVIC_ClearPendingIRQ(SCHEDULER_TC_IRQ);
+    NVIC_EnableIRQ(SCHEDULER_TC_IRQ);
+    TC_Start(SCHEDULER_TC, SCHEDULER_TC_CHANNEL);
+    return 1;
+#elif defined(ARDUINO_ARCH_ESP32)
+    if (periodUs == 0)
+    {
+        return 0;
+    }
+    if (schedulerTimer == NULL)
+    {
+        /* Count in microseconds from the APB clock */
+        schedulerTimer = timerBegin(3, (uint16_t)(getApbFrequency() / 1000000UL), true);
+        timerAttachInterrupt(schedulerTimer, &schedulerTimerISR, true);
+    }
+    timerAlarmDisable(schedulerTimer);
+    timerWrite(schedulerTimer, 0);
+    timerAlarmWrite(schedulerTimer, periodUs, true);
+    return 1;
+#endif
+}
+
+/* Stop the timer and hand it back in the state the Arduino core left it */
+static void schedulerTimerRelease(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+    uint8_T oldSREG = SREG;
+    cli();
+    SCHEDULER_TIMSK &= (uint8_T)~_BV(SCHEDULER_OCIEB);
+    /* Phase correct 8-bit PWM at clock/64, as set up by init() for analogWrite */
+    SCHEDULER_TCCRB = 0;
+    SCHEDULER_TCCRA = _BV(SCHEDULER_WGM0);
+    SCHEDULER_TCCRB = _BV(SCHEDULER_CS1) | _BV(SCHEDULER_CS0);
+    SREG = oldSREG;
+#elif defined(ARDUINO_ARCH_SAMD)
+    TC3->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+    TC3->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    schedulerTimerSync();
+    NVIC_DisableIRQ(TC3_IRQn);
+#elif defined(ARDUINO_ARCH_SAM)
+    SCHEDULER_TC->TC_CHANNEL[SCHEDULER_TC_CHANNEL].TC_IDR = ~0UL;
+    TC_Stop(SCHEDULER_TC, SCHEDULER_TC_CHANNEL);
+    NVIC_DisableIRQ(SCHEDULER_TC_IRQ);
+#elif defined(ARDUINO_ARCH_ESP32)
+    if (schedulerTimer != NULL)
+    {
+        timerAlarmDisable(schedulerTimer);
+        timerDetachInterrupt(schedulerTimer);
+        timerEnd(schedulerTimer);
+        schedulerTimer = NULL;
+    }
+#endif
+}
+#endif /* MW_HW_SCHEDULER */
+
 // Use this configureScheduler function when using Soft Real-Time. The SchedulerBaseRate is the actual sample time in float.
 void configureScheduler(float SchedulerBaseRate)
 {
 	deltaT = (unsigned long)(SchedulerBaseRate*TimeScaleConversion); // SchedulerBaseRate is in second. Convert it into millisecond/microsecond
-	
+    resetSchedulerStats();
+    oldtime = 0L;
+
+#if MW_HW_SCHEDULER
+    /* Periods the timer cannot generate, or a timer already driving PWM pins,
+     * keep using the soft real-time path */
+    schedulerTimerRunning = !timerPwmHoldsSchedulerTimer() && schedulerTimerSetup(deltaT);
+    schedulerTickServiced = schedulerTickCount;
+    if (schedulerTimerRunning)
+    {
+        enableSchedulerInterrupt();
+    }
+#endif
+
 	// This flag will trigger the streaming mode operation
     StreamingModeFlag=1;
 }
+
+// Returns 1 when the next base rate step is due
+uint8_T schedulerStepDue(void)
+{
+    unsigned long actualtime;
+#if MW_HW_SCHEDULER
+    if (schedulerTimerRunning)
+    {
+        uint8_T tickCount = schedulerTickCount;
+        unsigned long tickTime;
+#if defined(ARDUINO_ARCH_AVR)
+        uint8_T oldSREG;
+#endif
+        if (tickCount == schedulerTickServiced)
+        {
+            return 0;
+        }
+#if defined(ARDUINO_ARCH_AVR)
+        /* The tick time is four bytes wide on AVR */
+        oldSREG = SREG;
+        cli();
+        tickCount = schedulerTickCount;
+        tickTime = schedulerTickTime;
+        SREG = oldSREG;
+#else
+        tickTime = schedulerTickTime;
+#endif
+        /* Ticks missed while the previous step or the background server was
+         * running are dropped rather than executed back to back */
+        schedulerStats.missedTicks += (uint8_T)(tickCount - schedulerTickServiced - 1);
+        schedulerTickServiced = tickCount;
+        recordLateness(micros() - tickTime);
+        return 1;
+    }
+#endif
+    actualtime = micros();
+    if ((actualtime - oldtime) >= deltaT)
+    {
+        /* oldtime is 0 for the first step after configuration */
+        if (oldtime != 0)
+        {
+            recordLateness(actualtime - oldtime - deltaT);
+        }
+        oldtime = actualtime;
+        return 1;
+    }
+    return 0;
+}
+
 //Hook to enable the scheduler interrupt
 void enableSchedulerInterrupt(void)
 {
-
+#if MW_HW_SCHEDULER
+    if (!schedulerTimerRunning)
+    {
+        return;
+    }
+#if defined(ARDUINO_ARCH_AVR)
+    SCHEDULER_TIMSK |= _BV(SCHEDULER_OCIEB);
+#elif defined(ARDUINO_ARCH_SAMD)
+    TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+#elif defined(ARDUINO_ARCH_SAM)
+    SCHEDULER_TC->TC_CHANNEL[SCHEDULER_TC_CHANNEL].TC_IER = TC_IER_CPCS;
+#elif defined(ARDUINO_ARCH_ESP32)
+    timerAlarmEnable(schedulerTimer);
+#endif
+#endif
 }
 //Hook to disable the scheduler interrupt
 void disableSchedulerInterrupt(void)
 {
-
+#if MW_HW_SCHEDULER
+    if (!schedulerTimerRunning)
+    {
+        return;
+    }
+#if defined(ARDUINO_ARCH_AVR)
+    SCHEDULER_TIMSK &= (uint8_T)~_BV(SCHEDULER_OCIEB);
+#elif defined(ARDUINO_ARCH_SAMD)
+    TC3->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+#elif defined(ARDUINO_ARCH_SAM)
+    SCHEDULER_TC->TC_CHANNEL[SCHEDULER_TC_CHANNEL].TC_IDR = TC_IDR_CPCS;
+#elif defined(ARDUINO_ARCH_ESP32)
+    timerAlarmDisable(schedulerTimer);
+#endif
+#endif
 }
 //Hook to enable the global interrupt on the target
 void enableGlobalInterrupt(void)
@@ -35,5 +401,134 @@ void disableGlobalInterrupt(void)
 void stopScheduler(void)
 {
 	StreamingModeFlag = 0;
+#if MW_HW_SCHEDULER
+    if (schedulerTimerRunning)
+    {
+        schedulerTimerRelease();
+        schedulerTimerRunning = 0;
+    }
+#endif
+}
+
+// Returns 1 while the base rate steps come from the hardware timer
+uint8_T schedulerTimerInUse(void)
+{
+#if MW_HW_SCHEDULER
+    return schedulerTimerRunning;
+#else
+    return 0;
+#endif
+}
+
+// Set the rate of a group as a multiple of the base rate, with the first run offset steps from now
+uint8_T configureRateGroup(uint8_T group, uint16_T multiple, uint16_T offset)
+{
+    /* Group 0 cannot be disabled, the IO server streaming list depends on it */
+    if ((group >= MW_SCHEDULER_RATE_GROUPS) || ((group == 0) && (multiple == 0)) || ((multiple != 0) && (offset >= multiple)))
+    {
+        return 0;
+    }
+    rateGroups[group].multiple = multiple;
+    rateGroups[group].countdown = offset;
+    return 1;
+}
+
+// Register a task with a group. Returns 0 if the group is full or the task is already registered.
+uint8_T addRateGroupTask(uint8_T group, schedulerTask_T task)
+{
+    uint8_T i;
+    if ((group >= MW_SCHEDULER_RATE_GROUPS) || (task == NULL) || (rateGroups[group].numTasks >= MW_SCHEDULER_GROUP_TASKS))
+    {
+        return 0;
+    }
+    for (i = 0; i < rateGroups[group].numTasks; i++)
+    {
+        if (rateGroups[group].tasks[i] == task)
+        {
+            return 0;
+        }
+    }
+    rateGroups[group].tasks[rateGroups[group].numTasks++] = task;
+    return 1;
 }
 
+// Remove a task from whichever group it was registered with
+void removeRateGroupTask(schedulerTask_T task)
+{
+    uint8_T group, i;
+    for (group = 0; group < MW_SCHEDULER_RATE_GROUPS; group++)
+    {
+        for (i = 0; i < rateGroups[group].numTasks; i++)
+        {
+            if (rateGroups[group].tasks[i] == task)
+            {
+                rateGroups[group].numTasks--;
+                rateGroups[group].tasks[i] = rateGroups[group].tasks[rateGroups[group].numTasks];
+                rateGroups[group].tasks[rateGroups[group].numTasks] = NULL;
+                break;
+            }
+        }
+    }
+}
+
+// Group a task is registered with, or MW_SCHEDULER_RATE_GROUPS if none
+uint8_T rateGroupOfTask(schedulerTask_T task)
+{
+    uint8_T group, i;
+    for (group = 0; group < MW_SCHEDULER_RATE_GROUPS; group++)
+    {
+        for (i = 0; i < rateGroups[group].numTasks; i++)
+        {
+            if (rateGroups[group].tasks[i] == task)
+            {
+                return group;
+            }
+        }
+    }
+    return MW_SCHEDULER_RATE_GROUPS;
+}
+
+// Advance a group by one base rate step and run its tasks if it is due. Returns 1 if the group ran.
+uint8_T rateGroupStep(uint8_T group)
+{
+    rateGroup_T *rg = &rateGroups[group];
+    uint8_T i;
+    if (rg->multiple == 0)
+    {
+        return 0;
+    }
+    if (rg->countdown != 0)
+    {
+        rg->countdown--;
+        return 0;
+    }
+    rg->countdown = rg->multiple - 1;
+    for (i = 0; i < rg->numTasks; i++)
+    {
+        rg->tasks[i]();
+    }
+    return 1;
+}
+
+// Account for one execution of rt_OneStep() that took execTime microseconds
+void recordSchedulerExecution(unsigned long execTime)
+{
+    if (execTime > schedulerStats.maxExecUs)
+    {
+        schedulerStats.maxExecUs = execTime;
+    }
+    if (execTime > deltaT)
+    {
+        schedulerStats.overruns++;
+    }
+}
+
+const schedulerStats_T* getSchedulerStats(void)
+{
+    return &schedulerStats;
+}
+
+void resetSchedulerStats(void)
+{
+    memset(&schedulerStats, 0, sizeof(schedulerStats));
+}
@@ -4,13 +4,58 @@
  * @Copyright 2017-2020 The MathWorks, Inc.
  *
  */
+#ifndef SCHEDULER_CONFIGURATION_H
+#define SCHEDULER_CONFIGURATION_H
+
 #include "rtwtypes.h"
+#include "peripheralIncludes.h"
 #define TimeScaleConversion 1000000    // Convert second into microsecond
 
+/* Rate groups run every multiple-th base rate step, starting offset steps after
+ * configuration. Group 0 carries the IO server streaming list (serverScheduler),
+ * the other groups only run the loop() work the host moves to them with
+ * ASSIGN_RATE_GROUP_TASK, see schedulerArduino.cpp. */
+#define MW_SCHEDULER_RATE_GROUPS    4
+#define MW_SCHEDULER_GROUP_TASKS    4
+
+typedef void (*schedulerTask_T)(void);
+
+/* Step lateness is how long after its tick (or after deltaT in soft real-time)
+ * a step started. Buckets are bounded at 4, 16, 64, 256, 1024, 4096 and 16384 us. */
+#define MW_SCHEDULER_LATENESS_BUCKETS   8
+
+typedef struct
+{
+    uint32_T numSteps;
+    uint32_T missedTicks;       /* Timer ticks dropped because a step was still pending */
+    uint32_T overruns;          /* Steps that took longer than deltaT */
+    uint32_T maxExecUs;
+    uint32_T maxLatenessUs;
+    uint32_T latenessHistogram[MW_SCHEDULER_LATENESS_BUCKETS];
+} schedulerStats_T;
+
+/* Boards on which the scheduler hooks are backed by a hardware timer. The timer
+ * interrupt only latches the tick, rt_OneStep() still runs from loop() so that
+ * the transport is never used from interrupt context. On the Uno class parts
+ * Timer1 is owned by the Servo library, so those fall back to soft real-time
+ * scheduling when Servo is part of the server. Elsewhere on AVR the scheduler
+ * has a timer Servo does not take, see scheduler_configuration.c. */
+#if defined(ARDUINO_ARCH_AVR) && !(IO_CUSTOM_SERVO && (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__)))
+#define MW_HW_SCHEDULER 1
+#elif defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#define MW_HW_SCHEDULER 1
+#elif defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_ESP32)
+#define MW_HW_SCHEDULER 1
+#else
+#define MW_HW_SCHEDULER 0
+#endif
+
 extern volatile uint16_T TimerCounter;
 
 void configureScheduler(float);   // For soft-real time
 
+uint8_T schedulerStepDue(void);   // Polled from loop() to decide when rt_OneStep() runs
+
 void enableSchedulerInterrupt(void);
 
 void disableSchedulerInterrupt(void);
@@ -20,3 +65,23 @@ void enableGlobalInterrupt(void);
 void disableGlobalInterrupt(void);
 
 void stopScheduler(void);
+
+uint8_T schedulerTimerInUse(void);   // 1 while the base rate comes from the hardware timer
+
+uint8_T configureRateGroup(uint8_T group, uint16_T multiple, uint16_T offset);
+
+uint8_T addRateGroupTask(uint8_T group, schedulerTask_T task);
+
+void removeRateGroupTask(schedulerTask_T task);
+
+uint8_T rateGroupOfTask(schedulerTask_T task);   // MW_SCHEDULER_RATE_GROUPS when no group has the task
+
+uint8_T rateGroupStep(uint8_T group);   // Called from rt_OneStep() for every base rate step
+
+void recordSchedulerExecution(unsigned long execTime);
+
+const schedulerStats_T* getSchedulerStats(void);
+
+void resetSchedulerStats(void);
+
+#endif
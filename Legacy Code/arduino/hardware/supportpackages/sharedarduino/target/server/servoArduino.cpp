@@ -13,17 +13,34 @@
 #endif
 
 #include "servoArduino.h"
+#include "timerPwmArduino.h"
 
 #if IO_CUSTOM_SERVO
 #include "Servo.h"
 #if defined (ESP_H)
-    #include "PWMChannel.cpp"
+    #include "PWMChannel.h"
 #endif
 
 extern "C"{
     
     Servo *servoArray[IO_DIGITALIO_MODULES_MAX];
     
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+    /* Servo puts SERVOS_PER_TIMER servos on each of Timer5, 1, 3 and 4, in the
+     * order the objects are created, and keeps a timer from its first servo
+     * on. Timer4 is the scheduler's, so no more are created than the first
+     * three timers carry, and none that would take a timer running timer PWM */
+#define MAX_SERVO_OBJECTS (3*SERVOS_PER_TIMER)
+    static uint8_T numServoObjects = 0;
+    /* A PWM pin of each timer, in the order Servo takes them */
+    static const uint8_T servoTimerPins[] = {46, 11, 5};
+    
+    uint8_T servoTimersInUse(void)
+    {
+        return (uint8_T)((numServoObjects + SERVOS_PER_TIMER - 1)/SERVOS_PER_TIMER);
+    }
+#endif
+    
     void attachServo(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse)
     {
         uint8_T servoID;
@@ -46,15 +63,29 @@ extern "C"{
         index += sizeof(uint16_T);
         
         if (NULL == servoArray[servoID]) {
+#if defined(MAX_SERVO_OBJECTS)
+            if ((numServoObjects == MAX_SERVO_OBJECTS) ||
+                    timerPwmTimerClaimed(servoTimerPins[numServoObjects/SERVOS_PER_TIMER])) {
+                payloadBufferTx[(*peripheralDataSizeResponse)] = 0;
+                (*peripheralDataSizeResponse) += sizeof(uint8_T);
+                return;
+            }
+            numServoObjects++;
+#endif
             servoArray[servoID] = new Servo;
         }
         #if !defined(ESP_H)
             servoArray[servoID]->attach(signalPin, minPulseDuration, maxPulseDuration);
+            payloadBufferTx[(*peripheralDataSizeResponse)] = 1;
         #else
-            assignPWMChannel((uint8_T)signalPin);
-            uint8_T channel = getPWMChannel(signalPin);
-            servoArray[servoID]->attach(signalPin, channel, 0, 180, minPulseDuration, maxPulseDuration);//pin,channel,minangle,maxAngle,minPulseduration,maxPulseDuration
+            uint8_T channel = assignPWMChannel((uint8_T)signalPin, SERVO_LEDC_FREQUENCY, SERVO_LEDC_RESOLUTION);
+            if (channel != PWM_NO_CHANNEL)
+            {
+                servoArray[servoID]->attach(signalPin, channel, 0, 180, minPulseDuration, maxPulseDuration);//pin,channel,minangle,maxAngle,minPulseduration,maxPulseDuration
+            }
+            payloadBufferTx[(*peripheralDataSizeResponse)] = (channel != PWM_NO_CHANNEL);
         #endif
+        (*peripheralDataSizeResponse) += sizeof(uint8_T);
 #if DEBUG_FLAG == 2
         //adding two different message IDs since the address is 16bit for AVR boards and 32bits for ARM boards. 
         #if defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_SAMD) || defined ARDUINO_ARCH_RP2040  || defined(ARDUINO_ARCH_RENESAS_UNO)
@@ -107,6 +138,10 @@ extern "C"{
         
         if (NULL != servoArray[servoID]) {
             servoArray[servoID]->detach();
+#if defined(ESP_H)
+            /* The servo ID is its signal pin */
+            releasePWMChannel(servoID);
+#endif
 #if DEBUG_FLAG == 2
             DebugMsg.debugMsgID=DEBUGSERVODETACH;
             DebugMsg.args[num++]=servoID;
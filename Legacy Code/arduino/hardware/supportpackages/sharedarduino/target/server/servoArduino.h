@@ -16,7 +16,8 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-/* Attach the Servo motor */
+/* Attach the Servo motor. Responds with 1 when attached, 0 when no timer or
+ * channel is left for it */
 void attachServo(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
 /* Detach the Servo Motor */
 void detachServo(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
@@ -24,6 +25,10 @@ void detachServo(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* p
 void readPosition(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
 /* Set the position of servo motor shaft. */
 void writePosition(uint8_T* payloadBufferRx, uint8_T* payloadBufferTx, uint16_T* peripheralDataSizeResponse);
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+/* Number of timers Servo has taken, in its order Timer5, Timer1, Timer3 */
+uint8_T servoTimersInUse(void);
+#endif
 
 #ifdef __cplusplus
 }
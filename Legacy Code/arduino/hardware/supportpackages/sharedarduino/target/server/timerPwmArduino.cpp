@@ -0,0 +1,499 @@
+/**
+ * @file timerPwmArduino.cpp
+ *
+ * PWM from the hardware timers at the frequency the host asks for. On AVR the
+ * 16-bit timers run in fast PWM with TOP in ICRn, on SAMD21 the TCC timers run
+ * in normal PWM with TOP in PER. The prescaler is the smallest that fits the
+ * period, so the duty cycle gets as many steps as the frequency allows, up to
+ * 65536 on AVR. All pins of one timer share its frequency.
+ *
+ */
+
+#ifndef _Arduino_h_
+#define _Arduino_h_
+#include "Arduino.h"
+#endif
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include "wiring_private.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "timerPwmArduino.h"
+#include "scheduler_configuration.h"
+#if IO_CUSTOM_SERVO
+#include "servoArduino.h"
+#endif
+
+#if TIMER_PWM_SUPPORTED
+
+#if defined(ARDUINO_ARCH_AVR)
+    /* Registers of a 16-bit timer, in the types avr-libc declares them with */
+    struct avrTimer_t
+    {
+        volatile uint8_t* tccra;
+        volatile uint8_t* tccrb;
+        volatile uint16_t* tcnt;
+        volatile uint16_t* icr;
+        volatile uint16_t* ocr[3];
+    };
+
+    struct avrTimerPin_t
+    {
+        uint8_T pin;
+        uint8_T timer;
+        uint8_T channel;    /* 0, 1, 2 for OCnA, OCnB, OCnC */
+    };
+
+#define TIMER_PWM_AVR_TIMER(n) { &TCCR##n##A, &TCCR##n##B, &TCNT##n, &ICR##n, { &OCR##n##A, &OCR##n##B, &OCR##n##C } }
+
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+    /* OC1C and OC0A share pin 13, which is left to Timer0. Servo claims
+     * Timer5 first, Timer4 is the scheduler's. */
+    static const struct avrTimer_t avrTimers[] = {
+        TIMER_PWM_AVR_TIMER(1), TIMER_PWM_AVR_TIMER(3), TIMER_PWM_AVR_TIMER(4),
+#if !IO_CUSTOM_SERVO
+        TIMER_PWM_AVR_TIMER(5),
+#endif
+    };
+    static const struct avrTimerPin_t avrTimerPins[] = {
+        {11, 0, 0}, {12, 0, 1},
+        {5, 1, 0}, {2, 1, 1}, {3, 1, 2},
+        {6, 2, 0}, {7, 2, 1}, {8, 2, 2},
+#if !IO_CUSTOM_SERVO
+        {46, 3, 0}, {45, 3, 1}, {44, 3, 2},
+#endif
+    };
+#define TIMER_PWM_SCHEDULER_TIMER 2
+#if IO_CUSTOM_SERVO
+    /* Timer1 and Timer3 are the second and third timers Servo fills */
+#define TIMER_PWM_SERVO_TIMERS 2
+#endif
+#elif defined(__AVR_ATmega32U4__)
+    /* OC1C and OC0A share pin 11, which is left to Timer0. Servo uses Timer1,
+     * Timer3 is the scheduler's. */
+#if !IO_CUSTOM_SERVO
+    static const struct avrTimer_t avrTimers[] = { TIMER_PWM_AVR_TIMER(1), TIMER_PWM_AVR_TIMER(3) };
+    static const struct avrTimerPin_t avrTimerPins[] = { {9, 0, 0}, {10, 0, 1}, {5, 1, 0} };
+#define TIMER_PWM_SCHEDULER_TIMER 1
+#else
+    static const struct avrTimer_t avrTimers[] = { TIMER_PWM_AVR_TIMER(3) };
+    static const struct avrTimerPin_t avrTimerPins[] = { {5, 0, 0} };
+#define TIMER_PWM_SCHEDULER_TIMER 0
+#endif
+#else
+    /* Uno class parts have no OC1C. Timer1 is the scheduler's. */
+    static const struct avrTimer_t avrTimers[] = { { &TCCR1A, &TCCR1B, &TCNT1, &ICR1, { &OCR1A, &OCR1B, NULL } } };
+    static const struct avrTimerPin_t avrTimerPins[] = { {9, 0, 0}, {10, 0, 1} };
+#define TIMER_PWM_SCHEDULER_TIMER 0
+#endif
+
+#define TIMER_PWM_NUM_TIMERS    (sizeof(avrTimers)/sizeof(avrTimers[0]))
+#define TIMER_PWM_MAX_PINS      (sizeof(avrTimerPins)/sizeof(avrTimerPins[0]))
+
+    /* Clock select 1..5 of the 16-bit timers */
+    static const uint16_T timerPwmPrescaler[] = {1, 8, 64, 256, 1024};
+
+#elif defined(ARDUINO_ARCH_SAMD)
+    static Tcc* const samdTccs[] = {TCC0, TCC1, TCC2};
+
+#define TIMER_PWM_NUM_TIMERS    TCC_INST_NUM
+#define TIMER_PWM_MAX_PINS      8       /* CC channels of TCC0, TCC1 and TCC2 */
+
+    static const uint16_T timerPwmPrescaler[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+#endif
+
+#define TIMER_PWM_NUM_PRESCALERS (sizeof(timerPwmPrescaler)/sizeof(timerPwmPrescaler[0]))
+
+    struct timerPwmTimer_t
+    {
+        uint8_T users;          /* Bit per channel driving a pin */
+        uint8_T prescaler;
+        uint32_T top;
+    };
+    static struct timerPwmTimer_t timerPwmTimers[TIMER_PWM_NUM_TIMERS];
+
+    struct timerPwmPin_t
+    {
+        uint8_T pin;
+        uint8_T timer;
+        uint8_T channel;
+        real32_T dutyCycle;
+    };
+    static struct timerPwmPin_t timerPwmPins[TIMER_PWM_MAX_PINS];
+    static uint8_T numTimerPwmPins = 0;
+
+    /* Timer and channel that can drive a pin. Returns 0 if there are none */
+    static uint8_T findTimerChannel(uint8_T pin, uint8_T* timer, uint8_T* channel)
+    {
+#if defined(ARDUINO_ARCH_AVR)
+        for (uint8_T i = 0; i < TIMER_PWM_MAX_PINS; i++)
+        {
+            if (avrTimerPins[i].pin == pin)
+            {
+                *timer = avrTimerPins[i].timer;
+                *channel = avrTimerPins[i].channel;
+                return 1;
+            }
+        }
+        return 0;
+#else
+        uint32_T pwmChannel;
+        if ((pin >= PINS_COUNT) || !(g_APinDescription[pin].ulPinAttribute & (PIN_ATTR_TIMER | PIN_ATTR_TIMER_ALT)))
+        {
+            return 0;
+        }
+        pwmChannel = g_APinDescription[pin].ulPWMChannel;
+        if (GetTCNumber(pwmChannel) >= TCC_INST_NUM)
+        {
+            return 0;
+        }
+        *timer = (uint8_T)GetTCNumber(pwmChannel);
+        *channel = (uint8_T)GetTCChannelNumber(pwmChannel);
+        return 1;
+#endif
+    }
+
+    /* Largest TOP of a timer. On SAMD one count is kept above TOP for a
+     * compare that holds the output high */
+    static uint32_T timerMaxTop(uint8_T timer)
+    {
+#if defined(ARDUINO_ARCH_AVR)
+        return 0xFFFFUL;
+#else
+        return (timer == 2) ? 0xFFFEUL : 0xFFFFFEUL;
+#endif
+    }
+
+    /* Prescaler index and TOP for a frequency in Hz. Returns 0 if the timer
+     * cannot generate it with TIMER_PWM_MIN_STEPS steps */
+    static uint8_T timerPwmPeriod(uint8_T timer, real_T frequency, uint8_T* prescaler, uint32_T* top)
+    {
+        real_T cycles;
+
+        if (!(frequency > 0) || (frequency > (real_T)F_CPU / TIMER_PWM_MIN_STEPS))
+        {
+            return 0;
+        }
+        cycles = (real_T)F_CPU / frequency + 0.5;
+        for (uint8_T ps = 0; ps < TIMER_PWM_NUM_PRESCALERS; ps++)
+        {
+            if ((cycles / timerPwmPrescaler[ps]) <= (real_T)timerMaxTop(timer) + 1)
+            {
+                *prescaler = ps;
+                *top = (uint32_T)cycles / timerPwmPrescaler[ps] - 1;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+#if defined(ARDUINO_ARCH_SAMD)
+    static void tccSync(Tcc* tcc)
+    {
+        while (tcc->SYNCBUSY.reg);
+    }
+
+    /* Normal PWM at the prescaler and period given, from the 48 MHz GCLK0 */
+    static void tccSetup(uint8_T timer, uint8_T prescaler, uint32_T per)
+    {
+        Tcc* tcc = samdTccs[timer];
+        GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+                ((timer < 2) ? GCLK_CLKCTRL_ID_TCC0_TCC1 : GCLK_CLKCTRL_ID_TCC2_TC3));
+        while (GCLK->STATUS.bit.SYNCBUSY);
+        tcc->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+        tccSync(tcc);
+        tcc->CTRLA.reg = TCC_CTRLA_PRESCALER(prescaler);
+        tcc->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+        tccSync(tcc);
+        tcc->PER.reg = per;
+        tccSync(tcc);
+        tcc->CTRLA.reg |= TCC_CTRLA_ENABLE;
+        tccSync(tcc);
+    }
+#endif
+
+    /* Program a timer for PWM at a prescaler index and TOP. The counter
+     * restarts so that it is never left above a smaller TOP */
+    static void timerSetup(uint8_T timer, uint8_T prescaler, uint32_T top)
+    {
+#if defined(ARDUINO_ARCH_AVR)
+        const struct avrTimer_t* t = &avrTimers[timer];
+        uint8_T oldSREG = SREG;
+        cli();
+        *t->tccrb = 0;
+        /* Fast PWM with TOP = ICRn (mode 14). The bits are in the same place
+         * in all the 16-bit timers. Outputs already connected stay connected */
+        *t->tccra = (uint8_T)((*t->tccra & (_BV(COM1A1) | _BV(COM1A1 - 2) | _BV(COM1A1 - 4))) | _BV(WGM11));
+        *t->icr = (uint16_T)top;
+        *t->tcnt = 0;
+        *t->tccrb = (uint8_T)(_BV(WGM13) | _BV(WGM12) | (prescaler + 1));
+        SREG = oldSREG;
+#else
+        tccSetup(timer, prescaler, top);
+#endif
+        timerPwmTimers[timer].prescaler = prescaler;
+        timerPwmTimers[timer].top = top;
+    }
+
+    /* Hand a timer no pin uses back in the state the Arduino core left it */
+    static void timerRelease(uint8_T timer)
+    {
+#if defined(ARDUINO_ARCH_AVR)
+        const struct avrTimer_t* t = &avrTimers[timer];
+        uint8_T oldSREG = SREG;
+        cli();
+        /* Phase correct 8-bit PWM at clock/64, as set up by init() for analogWrite */
+        *t->tccrb = 0;
+        *t->tccra = _BV(WGM10);
+        *t->tccrb = _BV(CS11) | _BV(CS10);
+        SREG = oldSREG;
+#else
+        /* Normal PWM over 16 bits at clock/1, as analogWrite sets it up */
+        tccSetup(timer, 0, 0xFFFF);
+#endif
+    }
+
+    /* Drive a pin at a duty cycle in percent from its timer channel */
+    static void timerPwmOutput(struct timerPwmPin_t* p)
+    {
+        uint32_T top = timerPwmTimers[p->timer].top;
+        real32_T duty = (p->dutyCycle < 0) ? 0 : ((p->dutyCycle > 100) ? 100 : p->dutyCycle);
+        uint32_T compare = (uint32_T)((real_T)(top + 1) * duty / 100 + 0.5);
+#if defined(ARDUINO_ARCH_AVR)
+        const struct avrTimer_t* t = &avrTimers[p->timer];
+        /* COMnA1, COMnB1 and COMnC1 are bits 7, 5 and 3 */
+        uint8_T com = (uint8_T)_BV(COM1A1 - 2*p->channel);
+        uint8_T oldSREG;
+        if ((compare == 0) || (compare > top))
+        {
+            /* A compare of 0 still gives a one cycle pulse in fast PWM */
+            oldSREG = SREG;
+            cli();
+            *t->tccra &= (uint8_T)~com;
+            SREG = oldSREG;
+            digitalWrite(p->pin, compare ? HIGH : LOW);
+            return;
+        }
+        oldSREG = SREG;
+        cli();
+        *t->ocr[p->channel] = (uint16_T)compare;
+        *t->tccra |= com;
+        SREG = oldSREG;
+#else
+        /* The buffered compare takes effect at the end of the period, a compare
+         * above TOP holds the output high */
+        samdTccs[p->timer]->CCB[p->channel].reg = compare;
+        tccSync(samdTccs[p->timer]);
+#endif
+    }
+
+    static struct timerPwmPin_t* findTimerPwmPin(uint8_T pin)
+    {
+        for (uint8_T i = 0; i < numTimerPwmPins; i++)
+        {
+            if (timerPwmPins[i].pin == pin)
+            {
+                return &timerPwmPins[i];
+            }
+        }
+        return NULL;
+    }
+
+    /* Drive a pin from a timer already set up, starting at a duty cycle of 0 */
+    static void addTimerPwmPin(uint8_T pin, uint8_T timer, uint8_T channel)
+    {
+        struct timerPwmPin_t* p = &timerPwmPins[numTimerPwmPins++];
+
+        timerPwmTimers[timer].users |= (uint8_T)(1U << channel);
+        p->pin = pin;
+        p->timer = timer;
+        p->channel = channel;
+        p->dutyCycle = 0;
+        pinMode(pin, OUTPUT);
+#if defined(ARDUINO_ARCH_SAMD)
+        pinPeripheral(pin, (g_APinDescription[pin].ulPinAttribute & PIN_ATTR_TIMER) ? PIO_TIMER : PIO_TIMER_ALT);
+#endif
+        timerPwmOutput(p);
+    }
+
+    uint8_T timerPwmOpen(uint8_T pin, real_T frequency)
+    {
+        struct timerPwmPin_t* p = findTimerPwmPin(pin);
+        uint8_T timer, channel, prescaler;
+        uint32_T top;
+
+        if (p != NULL)
+        {
+            /* Opened again, possibly at another frequency */
+            return timerPwmSetFrequency(pin, frequency);
+        }
+        if ((numTimerPwmPins >= TIMER_PWM_MAX_PINS) || !findTimerChannel(pin, &timer, &channel) ||
+                !timerPwmPeriod(timer, frequency, &prescaler, &top))
+        {
+            return 0;
+        }
+#if defined(TIMER_PWM_SCHEDULER_TIMER)
+        if ((timer == TIMER_PWM_SCHEDULER_TIMER) && schedulerTimerInUse())
+        {
+            return 0;
+        }
+#endif
+#if defined(TIMER_PWM_SERVO_TIMERS)
+        /* Servo keeps a timer from its first servo on it */
+        if ((timer < TIMER_PWM_SERVO_TIMERS) && (servoTimersInUse() > timer + 1))
+        {
+            return 0;
+        }
+#endif
+        if (timerPwmTimers[timer].users == 0)
+        {
+            timerSetup(timer, prescaler, top);
+        }
+        else if ((timerPwmTimers[timer].prescaler != prescaler) || (timerPwmTimers[timer].top != top))
+        {
+            return 0;
+        }
+        addTimerPwmPin(pin, timer, channel);
+        return 1;
+    }
+
+    uint8_T timerPwmTimerClaimed(uint8_T pin)
+    {
+        uint8_T timer, channel;
+
+        return (findTimerChannel(pin, &timer, &channel) && (timerPwmTimers[timer].users != 0)) ? 1 : 0;
+    }
+
+    uint8_T timerPwmJoin(uint8_T pin)
+    {
+        uint8_T timer, channel;
+
+        if (findTimerPwmPin(pin) != NULL)
+        {
+            return 1;
+        }
+        if ((numTimerPwmPins >= TIMER_PWM_MAX_PINS) || !findTimerChannel(pin, &timer, &channel) ||
+                (timerPwmTimers[timer].users == 0))
+        {
+            return 0;
+        }
+        addTimerPwmPin(pin, timer, channel);
+        return 1;
+    }
+
+    uint8_T timerPwmSetFrequency(uint8_T pin, real_T frequency)
+    {
+        struct timerPwmPin_t* p = findTimerPwmPin(pin);
+        uint8_T prescaler;
+        uint32_T top;
+
+        if ((p == NULL) || !timerPwmPeriod(p->timer, frequency, &prescaler, &top))
+        {
+            return 0;
+        }
+        if ((timerPwmTimers[p->timer].prescaler == prescaler) && (timerPwmTimers[p->timer].top == top))
+        {
+            return 1;
+        }
+        /* The other pins of the timer would change frequency with it */
+        if (timerPwmTimers[p->timer].users != (uint8_T)(1U << p->channel))
+        {
+            return 0;
+        }
+        timerSetup(p->timer, prescaler, top);
+        timerPwmOutput(p);
+        return 1;
+    }
+
+    uint8_T timerPwmWrite(uint8_T pin, real_T dutyCycle)
+    {
+        struct timerPwmPin_t* p = findTimerPwmPin(pin);
+
+        if (p == NULL)
+        {
+            return 0;
+        }
+        p->dutyCycle = (real32_T)dutyCycle;
+        timerPwmOutput(p);
+        return 1;
+    }
+
+    void timerPwmClose(uint8_T pin)
+    {
+        struct timerPwmPin_t* p = findTimerPwmPin(pin);
+        uint8_T timer;
+
+        if (p == NULL)
+        {
+            return;
+        }
+        timer = p->timer;
+        p->dutyCycle = 0;
+        timerPwmOutput(p);
+        timerPwmTimers[timer].users &= (uint8_T)~(1U << p->channel);
+#if defined(ARDUINO_ARCH_SAMD)
+        /* Back to a port pin, driven low */
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+#endif
+        *p = timerPwmPins[--numTimerPwmPins];
+        if (timerPwmTimers[timer].users == 0)
+        {
+            timerRelease(timer);
+        }
+    }
+
+    uint8_T timerPwmHoldsSchedulerTimer(void)
+    {
+#if defined(TIMER_PWM_SCHEDULER_TIMER)
+        return (timerPwmTimers[TIMER_PWM_SCHEDULER_TIMER].users != 0);
+#else
+        return 0;
+#endif
+    }
+
+#else
+
+    uint8_T timerPwmOpen(uint8_T pin, real_T frequency)
+    {
+        return 0;
+    }
+
+    uint8_T timerPwmTimerClaimed(uint8_T pin)
+    {
+        return 0;
+    }
+
+    uint8_T timerPwmJoin(uint8_T pin)
+    {
+        return 0;
+    }
+
+    uint8_T timerPwmSetFrequency(uint8_T pin, real_T frequency)
+    {
+        return 0;
+    }
+
+    uint8_T timerPwmWrite(uint8_T pin, real_T dutyCycle)
+    {
+        return 0;
+    }
+
+    void timerPwmClose(uint8_T pin)
+    {
+    }
+
+    uint8_T timerPwmHoldsSchedulerTimer(void)
+    {
+        return 0;
+    }
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
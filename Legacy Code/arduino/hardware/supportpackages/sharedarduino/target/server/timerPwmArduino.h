@@ -0,0 +1,60 @@
+/**
+ * @file timerPwmArduino.h
+ *
+ * Provides headers to timerPwmArduino.cpp
+ *
+ */
+
+#ifndef TIMERPWMARDUINO_H
+#define TIMERPWMARDUINO_H
+
+#include "IO_include.h"
+#include "IO_peripheralInclude.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Boards whose 16-bit timers (AVR) or TCC timers (SAMD21) can run PWM at the
+ * frequency the host asks for. Elsewhere MW_PWM keeps using analogWrite. On
+ * the Uno class parts Timer1, the only 16-bit timer, is owned by Servo when
+ * it is part of the server. */
+#if defined(ARDUINO_ARCH_AVR) && (!IO_CUSTOM_SERVO || defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega32U4__))
+#define TIMER_PWM_SUPPORTED 1
+#elif defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#define TIMER_PWM_SUPPORTED 1
+#else
+#define TIMER_PWM_SUPPORTED 0
+#endif
+
+/* Fewest duty cycle steps a frequency must leave, below this analogWrite does as well */
+#define TIMER_PWM_MIN_STEPS 256UL
+
+/* Run a pin from its hardware timer at a frequency in Hz. Returns 0, leaving
+ * the pin to analogWrite, when the pin has no free timer channel, the timer
+ * cannot generate the frequency with TIMER_PWM_MIN_STEPS steps, or another
+ * pin of the same timer runs at a different frequency */
+uint8_T timerPwmOpen(uint8_T pin, real_T frequency);
+/* 1 when the timer of a pin runs timer PWM for some pin. analogWrite must not
+ * be used on such a timer, its compare values no longer match the TOP */
+uint8_T timerPwmTimerClaimed(uint8_T pin);
+/* Drive a pin from its timer at the frequency the timer already runs at.
+ * Returns 0 when the timer does not run timer PWM */
+uint8_T timerPwmJoin(uint8_T pin);
+/* Change the frequency of a timer PWM pin, keeping its duty cycle. Returns 0
+ * when the pin is not a timer PWM pin or the frequency cannot be generated */
+uint8_T timerPwmSetFrequency(uint8_T pin, real_T frequency);
+/* Set the duty cycle in percent with the full resolution of the timer.
+ * Returns 0 when the pin is not a timer PWM pin */
+uint8_T timerPwmWrite(uint8_T pin, real_T dutyCycle);
+/* Disconnect the pin from its timer, and return the timer to the Arduino core
+ * when no other pin uses it */
+void timerPwmClose(uint8_T pin);
+/* 1 while a PWM pin runs from the timer the hardware scheduler uses */
+uint8_T timerPwmHoldsSchedulerTimer(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif